@@ -0,0 +1,96 @@
+#include "AllocationCounter.hpp"
+
+#ifdef VSD_SLAM_COUNT_ALLOCATIONS
+
+#include <cstddef>
+#include <cerrno>
+
+/** glibc allocator behind the interposed entry points **/
+extern "C"
+{
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t nmemb, size_t size);
+    void *__libc_realloc(void *ptr, size_t size);
+    void *__libc_memalign(size_t alignment, size_t size);
+}
+
+/** Allocations of each thread. Initial-exec TLS does not allocate on access **/
+static __thread unsigned long long thread_allocations __attribute__((tls_model("initial-exec"))) = 0;
+
+extern "C"
+{
+    void *malloc(size_t size)
+    {
+        ++thread_allocations;
+        return __libc_malloc(size);
+    }
+
+    void *calloc(size_t nmemb, size_t size)
+    {
+        ++thread_allocations;
+        return __libc_calloc(nmemb, size);
+    }
+
+    void *realloc(void *ptr, size_t size)
+    {
+        /** realloc(ptr, 0) frees **/
+        if (size != 0)
+        {
+            ++thread_allocations;
+        }
+        return __libc_realloc(ptr, size);
+    }
+
+    void *memalign(size_t alignment, size_t size)
+    {
+        ++thread_allocations;
+        return __libc_memalign(alignment, size);
+    }
+
+    void *aligned_alloc(size_t alignment, size_t size)
+    {
+        ++thread_allocations;
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void **memptr, size_t alignment, size_t size)
+    {
+        if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0)
+        {
+            return EINVAL;
+        }
+
+        ++thread_allocations;
+        void *ptr = __libc_memalign(alignment, size);
+        if (ptr == NULL)
+        {
+            return ENOMEM;
+        }
+        *memptr = ptr;
+        return 0;
+    }
+}
+
+unsigned long long vsd_slam::allocationCount()
+{
+    return thread_allocations;
+}
+
+bool vsd_slam::allocationCounting()
+{
+    return true;
+}
+
+#else
+
+unsigned long long vsd_slam::allocationCount()
+{
+    return 0;
+}
+
+bool vsd_slam::allocationCounting()
+{
+    return false;
+}
+
+#endif
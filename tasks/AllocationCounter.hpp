@@ -0,0 +1,20 @@
+#ifndef VSD_SLAM_ALLOCATION_COUNTER_HPP
+#define VSD_SLAM_ALLOCATION_COUNTER_HPP
+
+namespace vsd_slam
+{
+    /**@brief Heap allocations made so far by the calling thread (malloc
+     * family, and so operator new and the Eigen aligned allocations).
+     *
+     * The allocations are only counted when the library is built with
+     * VSD_SLAM_COUNT_ALLOCATIONS, which interposes the glibc malloc.
+     * Otherwise it always returns zero.
+     */
+    unsigned long long allocationCount();
+
+    /**@brief Whether the heap allocations are counted
+     */
+    bool allocationCounting();
+}
+
+#endif
@@ -0,0 +1,722 @@
+#include "BackEnd.hpp"
+
+//#define DEBUG_FEATURE_PRINTS 1
+
+#ifdef DEBUG_FEATURE_PRINTS
+#include <iostream>
+#endif
+
+#define KEYFRAME_PERIOD 50 /** Image frames between keyframes (the optimization runs at each keyframe) **/
+
+/** GTSAM Optimizer **/
+#include <gtsam/nonlinear/LevenbergMarquardtOptimizer.h>
+
+using namespace vsd_slam;
+
+BackEnd::BackEnd()
+{
+    /** Set pose and landmark symbol identifiers **/
+    this->pose_key = 'x';
+    this->landmark_key = 'l';
+    this->pose_idx = 0;
+
+    /******************************/
+    /*** Control Flow Variables ***/
+    /******************************/
+    this->overloaded = false;
+    this->delta_pose_pending = 0;
+    this->shed_frame_counter = 0;
+    this->frames_shed = false;
+
+    this->graph_capacity = 1;
+    this->factor_graph_capacity = 0;
+    this->frame_allocations_start = 0;
+
+    this->delta_pose.invalidate();
+}
+
+BackEnd::~BackEnd()
+{
+}
+
+void BackEnd::configure(const frame_helper::StereoCalibration &calib,
+                    const std::vector<vsd_slam::StereoRigCamera> &rig_cameras,
+                    const double pixel_sigma, const int graph_capacity,
+                    const vsd_slam::LandmarkConfiguration &landmark_config,
+                    const vsd_slam::OverloadConfiguration &overload_config)
+{
+    /** Read the camera calibration parameters **/
+    this->stereo_calib = this->stereoCalibration(calib);
+
+    /** Reference camera and the other cameras of the rig **/
+    this->cameras.clear();
+    StereoCamera reference_camera;
+    reference_camera.calib = this->stereo_calib;
+    reference_camera.reference_camera_tf.setIdentity();
+    this->cameras.push_back(reference_camera);
+
+    for (std::vector<vsd_slam::StereoRigCamera>::const_iterator it = rig_cameras.begin(); it != rig_cameras.end(); ++it)
+    {
+        StereoCamera camera;
+        camera.calib = this->stereoCalibration(it->calib);
+        camera.reference_camera_tf = it->reference_camera.toTransform();
+        camera.body_P_sensor = gtsam::Pose3(gtsam::Rot3(it->reference_camera.orientation), gtsam::Point3(it->reference_camera.position));
+        this->cameras.push_back(camera);
+    }
+    this->workspaces.clear();
+    this->workspaces.resize(this->cameras.size());
+
+    /** Factor pool of each camera (released after any graph holding its factors) **/
+    this->factor_graph.reset();
+    this->factor_pools.clear();
+    for (size_t i = 0; i < this->cameras.size(); ++i)
+    {
+        this->factor_pools.push_back(boost::shared_ptr< boost::pool<> >(new boost::pool<>(STEREO_FACTOR_CHUNK_SIZE, 1024)));
+    }
+
+    /** Persistent workers: one per additional camera of the rig, and at
+     * least the hardware concurrency for the triangulation of large frames **/
+    this->worker_pool.start(std::max<size_t>(this->cameras.size(), std::max(1u, std::thread::hardware_concurrency())) - 1);
+
+    /** Noise model of pixel coordinates (shared by all the stereo factors) **/
+    this->pixel_noise_model = gtsam::noiseModel::Isotropic::Sigma(3, pixel_sigma);
+
+    this->graph_capacity = std::max(graph_capacity, 1);
+
+    /** Landmark initialization **/
+    this->landmark_config = landmark_config;
+
+    /** Overload policy **/
+    this->overload_config = overload_config;
+    if (this->overload_config.subsample_factor == 0)
+    {
+        this->overload_config.subsample_factor = 1;
+    }
+}
+
+void BackEnd::cleanup()
+{
+    /** Stop the workers **/
+    this->worker_pool.stop();
+
+    /** Reset GTSAM (the graph and the workspaces before the factor pools) **/
+    this->factor_graph.reset();
+    this->factor_graph_capacity = 0;
+    this->estimate_values.reset();
+    this->pixel_noise_model.reset();
+    this->cameras.clear();
+    this->workspaces.clear();
+    this->factor_pools.clear();
+    this->new_landmarks.clear();
+
+    /** Reset estimation **/
+    this->pose_idx = 0;
+    this->delta_pose.invalidate();
+
+    /** Reset overload handling **/
+    this->overloaded = false;
+    this->delta_pose_pending = 0;
+    this->shed_frame_counter = 0;
+    this->frames_shed = false;
+    this->last_features_time = base::Time();
+    this->backend_stats = vsd_slam::BackEndStatistics();
+}
+
+void BackEnd::initialization(const Eigen::Affine3d &tf, const Eigen::Affine3d &body_sensor_tf)
+{
+    /**********************************************
+    **  Cumulative delta pose initialization
+    ***********************************************/
+    this->cumulative_delta_pose.initUnknown();
+    base::Matrix6d cov; cov.setIdentity(); cov *= 1e-10;
+    this->cumulative_delta_pose.pose.setCovariance(cov);
+    this->cumulative_delta_pose.velocity.setCovariance(cov);
+    this->pose_delta_pose = this->cumulative_delta_pose;
+
+    /***************************/
+    /**    Initialization     **/
+    /***************************/
+    gtsam::Symbol frame_id = gtsam::Symbol(this->pose_key, this->pose_idx);
+    gtsam::Pose3 first_pose(gtsam::Rot3(tf.rotation()), gtsam::Point3(tf.translation()));
+
+    /** Create the factor graph **/
+    this->factor_graph.reset(new gtsam::NonlinearFactorGraph());
+    this->factor_graph_capacity = this->graph_capacity;
+    this->factor_graph->reserve(this->factor_graph_capacity);
+
+    /** Constrain the first pose such that it cannot change from its original value during optimization
+    NOTE: NonlinearEquality forces the optimizer to use QR rather than Cholesky
+    QR is much slower than Cholesky, but numerically more stable **/
+    this->factor_graph->push_back(gtsam::NonlinearEquality<gtsam::Pose3>(frame_id, first_pose));
+
+    /** Create the estimated values **/
+    this->estimate_values.reset(new gtsam::Values());
+
+    /** Insert first pose in initial estimates **/
+    this->estimate_values->insert(frame_id, first_pose);
+
+    /*************************
+    ** Pose initialization  **
+    *************************/
+    this->pose_with_cov.setPose(tf);
+    this->pose_with_cov.pose.setCovariance(cov);
+    this->pose_with_cov.velocity.setVelocity(base::Vector6d::Zero());
+    this->pose_with_cov.velocity.setCovariance(cov);
+
+    /********************************
+     ** Body Sensor initialization **
+    *********************************/
+    this->body_sensor_bs.initUnknown();
+    this->body_sensor_bs.setPose(body_sensor_tf);
+
+    return;
+}
+
+bool BackEnd::addDeltaPose(const base::samples::RigidBodyState &delta_pose_sample)
+{
+    /** A new sample arrived to the input port **/
+    if (this->delta_pose_pending == 0)
+    {
+        this->delta_pose = delta_pose_sample;
+    }
+    else
+    {
+        /** Coalesce it with the pending samples in a single increment **/
+        base::samples::BodyState delta_pose_increment;
+        delta_pose_increment = delta_pose_sample;
+        this->delta_pose = this->delta_pose * delta_pose_increment;
+        this->delta_pose.velocity = delta_pose_increment.velocity;
+        this->delta_pose.time = delta_pose_increment.time;
+        this->backend_stats.coalesced_delta_poses++;
+    }
+    this->delta_pose_pending++;
+
+    /** The back-end is behind: integrate the increment with the next features sample **/
+    return !(this->overloaded && this->overload_config.coalesce_delta_poses);
+}
+
+bool BackEnd::deltaPosePending() const
+{
+    return this->delta_pose_pending > 0;
+}
+
+void BackEnd::integrateDeltaPose(const Eigen::Affine3d &body_sensor_tf)
+{
+    /** Delta pose in sensor frame **/
+    /** Ts(k-1)_s(k) = Ts(k-1)_b(k-1) * Tb(k-1)_b(k) * Tb(k)_s(k) **/
+    this->delta_pose.setPose(this->body_sensor_bs.getPose().inverse() * this->delta_pose.getPose() * body_sensor_tf);
+    this->delta_pose.linear_velocity() = this->delta_pose.orientation() * this->delta_pose.linear_velocity();
+    this->delta_pose.angular_velocity() = this->delta_pose.orientation() * this->delta_pose.angular_velocity();
+    /** TO-DO: what happed with the uncertainty since body_sensor_tf does not have uncertainty information **/
+
+    /** Cumulative delta pose **/
+    this->cumulative_delta_pose = this->cumulative_delta_pose * this->delta_pose;
+    this->delta_pose_pending = 0;
+
+    /** Store Tbody_sensor **/
+    this->body_sensor_bs.setPose(body_sensor_tf);
+}
+
+void BackEnd::startFrame()
+{
+    /** Allocations of the features sample (see updateBacklog) **/
+    this->backend_stats.frame_allocations = 0;
+    this->frame_allocations_start = allocationCount();
+}
+
+bool BackEnd::isKeyFrame(const unsigned int img_idx) const
+{
+    return (img_idx % KEYFRAME_PERIOD) == 0;
+}
+
+unsigned int BackEnd::sheddingStride(const unsigned int img_idx)
+{
+    if (!this->overloaded || this->isKeyFrame(img_idx))
+    {
+        return 1;
+    }
+
+    switch (this->overload_config.shedding_policy)
+    {
+    case SHED_DROP_FRAMES:
+        return 0;
+    case SHED_SUBSAMPLE_FRAMES:
+        return ((this->shed_frame_counter++ % this->overload_config.subsample_factor) == 0)? 1 : 0;
+    case SHED_SUBSAMPLE_FEATURES:
+        return this->overload_config.subsample_factor;
+    default:
+        return 1;
+    }
+}
+
+void BackEnd::shedFrame(const unsigned int features_size)
+{
+    this->backend_stats.dropped_frames++;
+    this->frames_shed = true;
+    this->backend_stats.dropped_features += features_size;
+}
+
+gtsam::Symbol BackEnd::addPose()
+{
+    /****************************************
+    ** Increase in one unit the pose index **
+    ****************************************/
+    this->pose_idx++;
+
+    /****************************************************
+    **   Store the delta pose in the factor graph     **
+    ****************************************************/
+
+    /** Symbols **/
+    gtsam::Symbol symbol_prev = gtsam::Symbol(this->pose_key, this->pose_idx-1);
+    gtsam::Symbol symbol_current = gtsam::Symbol(this->pose_key, this->pose_idx);
+
+    /** Compute variance **/
+    base::Matrix6d cov_cumulative_delta_pose;
+    cov_cumulative_delta_pose << this->cumulative_delta_pose.cov_position(), Eigen::Matrix3d::Zero(),
+                              Eigen::Matrix3d::Zero(), this->cumulative_delta_pose.cov_orientation();
+
+    Eigen::SelfAdjointEigenSolver<base::Matrix6d> ev(cov_cumulative_delta_pose);
+    base::Vector6d var_cumulative_delta_pose = ev.eigenvalues();
+
+
+    /** Add the delta pose to the factor graph. TO-DO: probably not needed **/
+    /**  BetweenFactor in GTSAM. Also after shed frames: the overload policy
+     * can leave consecutive poses without common landmarks, and the
+     * coalesced odometry keeps the graph connected **/
+    if (this->pose_idx == 1 || this->frames_shed)
+    {
+        this->factor_graph->add(gtsam::BetweenFactor<gtsam::Pose3>(symbol_prev, symbol_current,
+                gtsam::Pose3(gtsam::Rot3(this->cumulative_delta_pose.orientation()), gtsam::Point3(this->cumulative_delta_pose.position())),
+                gtsam::noiseModel::Diagonal::Variances(var_cumulative_delta_pose)));
+    }
+
+    /***********************************************
+     * Add the cumulative delta pose to the pose
+    ***********************************************/
+
+    /** Compute the pose estimate **/
+    this->pose_with_cov =  this->pose_with_cov * this->cumulative_delta_pose;
+
+    /***********************************************
+    * Store Pose estimated values in GTSAM
+    * **********************************************/
+    gtsam::Pose3 current_pose(gtsam::Rot3(this->pose_with_cov.orientation()), gtsam::Point3(this->pose_with_cov.position()));
+    this->estimate_values->insert(symbol_current, current_pose);
+
+    /****************************************************/
+    /** Reset the accumulated delta pose **/
+    /****************************************************/
+    this->pose_delta_pose = this->cumulative_delta_pose;
+    this->cumulative_delta_pose.initUnknown();
+    this->frames_shed = false;
+    base::Matrix6d cov; cov.setIdentity(); cov *= 1e-10;
+    this->cumulative_delta_pose.pose.setCovariance(cov); /** Composed by the delta poses (odometry factor) **/
+    this->cumulative_delta_pose.velocity.setCovariance(cov);
+    this->pose_with_cov.pose.setCovariance(cov);
+    this->pose_with_cov.velocity.setCovariance(cov);
+
+    return symbol_current;
+}
+
+void BackEnd::addFeatures(const ::visual_stereo::ExteroFeatures *frames, const size_t number_cameras,
+                        const unsigned int feature_stride, const gtsam::Symbol &pose_symbol)
+{
+    /** Reserve the graph capacity for the factors of this frame **/
+    unsigned int features_size = 0;
+    size_t new_factors = 0;
+    for (size_t i = 0; i < number_cameras; ++i)
+    {
+        features_size += frames[i].features.size();
+        new_factors += (frames[i].features.size() + feature_stride - 1) / feature_stride;
+    }
+    this->reserveGraph(new_factors);
+
+    if (number_cameras == 1)
+    {
+        /** Single camera: construct directly in the graph (the triangulation can use the workers) **/
+        StereoFactorsWorkspace &workspace(this->workspaces[0]);
+        this->stereoFactors(0, frames[0], feature_stride, pose_symbol, *(this->factor_graph), workspace, true);
+        this->addCount(workspace.count);
+    }
+    else
+    {
+        /** Per-camera factor construction in the worker pool. The shared
+         * graph and values are only read until the synchronization point **/
+        for (size_t i = 0; i < number_cameras; ++i)
+        {
+            this->workspaces[i].graph.resize(0);
+            this->workspaces[i].graph.reserve((frames[i].features.size() + feature_stride - 1) / feature_stride);
+        }
+        StereoFactorsJob job = {this, frames, feature_stride, &pose_symbol};
+        this->worker_pool.run(&BackEnd::stereoFactorsTask, &job, number_cameras);
+
+        /** Synchronization point: merge in the camera order **/
+        for (size_t i = 0; i < number_cameras; ++i)
+        {
+            StereoFactorsWorkspace &workspace(this->workspaces[i]);
+            this->factor_graph->push_back(workspace.graph.begin(), workspace.graph.end());
+            workspace.graph.resize(0);
+            this->addCount(workspace.count);
+        }
+    }
+
+    /** Initial values of the new landmarks of all the cameras **/
+    this->insertLandmarks(number_cameras);
+
+    /** Features shed by subsampling the frame **/
+    this->backend_stats.dropped_features += features_size - new_factors;
+}
+
+void BackEnd::optimize()
+{
+    gtsam::LevenbergMarquardtParams params;
+    params.orderingType = gtsam::Ordering::METIS;
+    gtsam::LevenbergMarquardtOptimizer optimizer (*(this->factor_graph), *(this->estimate_values), params);
+
+    /** Store in the values **/
+    this->estimate_values.reset(new gtsam::Values(optimizer.optimize()));
+
+    return;
+}
+
+void BackEnd::updateBacklog(const base::Time &timestamp, const double processing_time)
+{
+    /** Processing time of this sample against the period of the incoming samples **/
+    double period = processing_time;
+    if (!this->last_features_time.isNull())
+    {
+        period = (timestamp - this->last_features_time).toSeconds();
+    }
+    this->last_features_time = timestamp;
+
+    /** The backlog grows while the processing takes longer than the period **/
+    this->backend_stats.backlog = std::max(0.00, this->backend_stats.backlog + processing_time - period);
+    this->overloaded = this->backend_stats.backlog > this->overload_config.max_backlog;
+    if (!this->overloaded)
+    {
+        this->shed_frame_counter = 0;
+    }
+
+    /** Allocations of the calling thread (the worker threads are already added) **/
+    this->backend_stats.frame_allocations += allocationCount() - this->frame_allocations_start;
+
+    this->backend_stats.time = timestamp;
+    this->backend_stats.factors = this->factor_graph->size();
+    this->backend_stats.values = this->estimate_values->size();
+    this->backend_stats.overloaded = this->overloaded;
+    this->backend_stats.processing_time = processing_time;
+}
+
+bool BackEnd::processFeatures(const ::visual_stereo::ExteroFeatures *frames, const size_t number_cameras,
+                        const unsigned int img_idx, const base::Time &time, const Eigen::Affine3d &body_sensor_tf)
+{
+    const base::Time start_time = base::Time::now();
+
+    /** Statistics (allocations) of this frame **/
+    this->startFrame();
+
+    /*********************************************/
+    /** Overload policy for the non-keyframes **/
+    /*********************************************/
+    const unsigned int feature_stride = this->sheddingStride(img_idx);
+    if (feature_stride == 0)
+    {
+        unsigned int features_size = 0;
+        for (size_t i = 0; i < number_cameras; ++i)
+        {
+            features_size += frames[i].features.size();
+        }
+        this->shedFrame(features_size);
+    }
+    else
+    {
+        /** Integrate the coalesced delta poses **/
+        if (this->deltaPosePending())
+        {
+            this->integrateDeltaPose(body_sensor_tf);
+        }
+
+        /** New pose with the cumulative delta pose and its stereo factors **/
+        const gtsam::Symbol pose_symbol = this->addPose();
+        this->addFeatures(frames, number_cameras, feature_stride, pose_symbol);
+
+        /** Optimize **/
+        if (this->isKeyFrame(img_idx))
+        {
+            this->optimize();
+        }
+    }
+
+    /** Processing time of this sample against the period of the incoming samples **/
+    this->updateBacklog(time, (base::Time::now() - start_time).toSeconds());
+
+    return feature_stride > 0;
+}
+
+void BackEnd::stereoFactorsTask(void *context, const size_t camera_idx)
+{
+    const StereoFactorsJob &job(*static_cast<StereoFactorsJob*>(context));
+    StereoFactorsWorkspace &workspace(job.back_end->workspaces[camera_idx]);
+
+    /** Allocations of a worker thread (the calling thread is counted with the frame) **/
+    const unsigned long long allocations_start = allocationCount();
+    job.back_end->stereoFactors(camera_idx, job.frames[camera_idx], job.feature_stride, *job.pose_symbol,
+            workspace.graph, workspace, false);
+    if (camera_idx > 0)
+    {
+        workspace.count.allocations = allocationCount() - allocations_start;
+    }
+}
+
+void BackEnd::stereoFactors(const size_t camera_idx, const ::visual_stereo::ExteroFeatures &frame,
+                        const unsigned int feature_stride, const gtsam::Symbol &pose_symbol,
+                        gtsam::NonlinearFactorGraph &graph, StereoFactorsWorkspace &workspace,
+                        const bool parallel)
+{
+    const StereoCamera &camera(this->cameras[camera_idx]);
+    workspace.count = StereoFactorsCount();
+
+    /** Tnav_camera = Tnav_reference * Treference_camera **/
+    const Eigen::Affine3d nav_camera_tf (this->pose_with_cov.getPose() * camera.reference_camera_tf);
+
+    /** Features to process and their symbols **/
+    const size_t features_size = (frame.features.size() + feature_stride - 1) / feature_stride;
+    workspace.feature_keys.resize(features_size);
+    workspace.new_features.clear();
+    for (size_t i = 0; i < features_size; ++i)
+    {
+        workspace.feature_keys[i] = this->landmarkSymbol(frame.features[i * feature_stride].index);
+        if (!this->estimate_values->exists(workspace.feature_keys[i]))
+        {
+            workspace.new_features.push_back(i * feature_stride);
+        }
+    }
+
+    /******************************************************
+     * Batch initialization of the new landmarks
+    ******************************************************/
+    this->landmarksInitialization(camera, nav_camera_tf, frame, workspace, parallel);
+
+    /** Factors out of the pool of this camera (no lock shared with the other cameras) **/
+    const StereoFactorAllocator allocator(this->factor_pools[camera_idx].get());
+
+    for (size_t i = 0, new_idx = 0; i < features_size; ++i)
+    {
+        const visual_stereo::Feature &feature(frame.features[i * feature_stride]);
+        gtsam::Symbol feature_symbol(workspace.feature_keys[i]);
+
+        /** Skip the observation of a landmark rejected at initialization **/
+        if (new_idx < workspace.new_features.size() && workspace.new_features[new_idx] == i * feature_stride)
+        {
+            if (!workspace.accepted[new_idx++])
+            {
+                continue;
+            }
+        }
+
+        /** Get the feature stereo point **/
+        base::Vector3d const &stereo_point(feature.stereo_point);
+
+        /******************************************************
+        * Set Generic Stereo Factor and features pose in GTSAM
+        ******************************************************/
+        #ifdef DEBUG_FEATURE_PRINTS
+        std::cout<<"[VSD_SLAM FEATURES ] STEREO_FACTOR: "<<std::string(pose_symbol)
+            <<" -> "<< std::string(feature_symbol)<<std::endl;
+        #endif
+        graph.push_back(boost::allocate_shared<StereoFactor>(allocator,
+                    gtsam::StereoPoint2(stereo_point[0], stereo_point[1], stereo_point[2]),
+                    this->pixel_noise_model, pose_symbol, feature_symbol, camera.calib, camera.body_P_sensor));
+    }
+}
+
+void BackEnd::landmarksInitialization(const StereoCamera &camera, const Eigen::Affine3d &nav_camera_tf,
+                                const ::visual_stereo::ExteroFeatures &frame, StereoFactorsWorkspace &workspace,
+                                const bool parallel)
+{
+    const std::vector<size_t> &new_features(workspace.new_features);
+    const size_t number_landmarks = new_features.size();
+    workspace.accepted.assign(number_landmarks, 0);
+    workspace.landmark_keys.clear();
+    if (number_landmarks == 0)
+    {
+        return;
+    }
+
+    /** Grow the buffers geometrically (Eigen matrices do not keep a capacity) **/
+    if (static_cast<size_t>(workspace.stereo_points.cols()) < number_landmarks)
+    {
+        const Eigen::DenseIndex capacity = std::max<Eigen::DenseIndex>(number_landmarks, 2 * workspace.stereo_points.cols());
+        workspace.stereo_points.resize(3, capacity);
+        workspace.camera_points.resize(3, capacity);
+        workspace.nav_points.resize(3, capacity);
+        workspace.disparity.resize(capacity);
+    }
+
+    /** Gather the stereo points in columns **/
+    for (size_t i = 0; i < number_landmarks; ++i)
+    {
+        workspace.stereo_points.col(i) = frame.features[new_features[i]].stereo_point;
+    }
+
+    /** Triangulation in parallel across the features for large frames.
+     * The kernel works in the workspace buffers and does not allocate **/
+    size_t number_tasks = 1;
+    if (parallel)
+    {
+        number_tasks = std::min<size_t>(this->worker_pool.concurrency(),
+                std::max<size_t>(1, number_landmarks / std::max(1u, this->landmark_config.parallel_min_features)));
+    }
+    if (number_tasks > 1)
+    {
+        TriangulationJob job = {this, &camera, &nav_camera_tf, &frame, &workspace,
+            (number_landmarks + number_tasks - 1) / number_tasks, number_landmarks};
+        this->worker_pool.run(&BackEnd::triangulationTask, &job, number_tasks);
+    }
+    else
+    {
+        this->triangulationKernel(camera, nav_camera_tf, frame, 0, number_landmarks, workspace);
+    }
+
+    /** Keys and points of the accepted landmarks, compacted in place **/
+    for (size_t i = 0; i < number_landmarks; ++i)
+    {
+        if (!workspace.accepted[i])
+        {
+            workspace.count.rejected_landmarks++;
+            continue;
+        }
+
+        const size_t landmark_idx = workspace.landmark_keys.size();
+        workspace.landmark_keys.push_back(this->landmarkSymbol(frame.features[new_features[i]].index));
+        workspace.nav_points.col(landmark_idx) = workspace.nav_points.col(i);
+
+        #ifdef DEBUG_FEATURE_PRINTS
+        std::cout<<"[VSD_SLAM FEATURES ] FEATURE POSE["<< std::string(gtsam::Symbol(workspace.landmark_keys.back())) <<"]: "<<
+            workspace.nav_points.col(landmark_idx).transpose()<<std::endl;
+        #endif
+    }
+}
+
+void BackEnd::triangulationTask(void *context, const size_t chunk_idx)
+{
+    const TriangulationJob &job(*static_cast<TriangulationJob*>(context));
+    const size_t begin = std::min(chunk_idx * job.chunk, job.number_landmarks);
+    job.back_end->triangulationKernel(*job.camera, *job.nav_camera_tf, *job.frame, begin,
+            std::min(begin + job.chunk, job.number_landmarks), *job.workspace);
+}
+
+void BackEnd::triangulationKernel(const StereoCamera &camera, const Eigen::Affine3d &nav_camera_tf,
+                            const ::visual_stereo::ExteroFeatures &frame, const size_t begin, const size_t end,
+                            StereoFactorsWorkspace &workspace) const
+{
+    if (begin >= end)
+    {
+        return;
+    }
+
+    const gtsam::Cal3_S2Stereo &K(*camera.calib);
+    const Eigen::DenseIndex size = end - begin;
+    const Eigen::Matrix3Xd::ColsBlockXpr stereo (workspace.stereo_points.middleCols(begin, size));
+    Eigen::Matrix3Xd::ColsBlockXpr points (workspace.camera_points.middleCols(begin, size));
+    Eigen::Matrix3Xd::ColsBlockXpr nav_points (workspace.nav_points.middleCols(begin, size));
+    Eigen::Array<double, 1, Eigen::Dynamic>::SegmentReturnType disparity (workspace.disparity.segment(begin, size));
+
+    /** Stereo triangulation: Z = fx * b / (u_left - u_right), X = (u_left - cx) * Z / fx, Y = (v - cy) * Z / fy.
+     * Evaluated in the workspace buffers (no temporaries) **/
+    disparity = stereo.row(0).array() - stereo.row(1).array();
+    points.row(2) = ((K.fx() * K.baseline()) * disparity.inverse()).matrix();
+    points.row(0) = ((stereo.row(0).array() - K.px()) * points.row(2).array() / K.fx()).matrix();
+    points.row(1) = ((stereo.row(2).array() - K.py()) * points.row(2).array() / K.fy()).matrix();
+
+    /** Cross-check against the front-end point and its covariance (Mahalanobis distance) **/
+    for (Eigen::DenseIndex i = 0; i < size; ++i)
+    {
+        const visual_stereo::Feature &feature(frame.features[workspace.new_features[begin + i]]);
+        /** Also rejects NaN disparities and non-finite points (e.g.: zero disparity) **/
+        if (!(disparity[i] >= this->landmark_config.min_disparity) || !points.col(i).allFinite())
+        {
+            continue;
+        }
+
+        const base::Vector3d error (points.col(i) - feature.point_3d);
+        Eigen::LDLT<base::Matrix3d> cov_ldlt(feature.cov_3d);
+        if (cov_ldlt.info() == Eigen::Success && cov_ldlt.isPositive() && cov_ldlt.vectorD().minCoeff() > 0.00)
+        {
+            workspace.accepted[begin + i] = (error.dot(cov_ldlt.solve(error)) < this->landmark_config.mahalanobis_gate);
+        }
+        else
+        {
+            /** No usable covariance: trust the triangulation **/
+            workspace.accepted[begin + i] = 1;
+        }
+    }
+
+    /** Transform to the navigation frame: p_navigation_frame = Tnav_sensor_frame * Tp_sensor_frame **/
+    nav_points.noalias() = nav_camera_tf.linear().lazyProduct(points);
+    nav_points.colwise() += nav_camera_tf.translation();
+}
+
+void BackEnd::insertLandmarks(const size_t number_cameras)
+{
+    /** Accepted new landmarks of the cameras **/
+    this->new_landmarks.clear();
+    for (size_t camera_idx = 0; camera_idx < number_cameras; ++camera_idx)
+    {
+        const std::vector<gtsam::Key> &landmark_keys(this->workspaces[camera_idx].landmark_keys);
+        for (size_t i = 0; i < landmark_keys.size(); ++i)
+        {
+            this->new_landmarks.push_back(NewLandmark(landmark_keys[i], camera_idx, i));
+        }
+    }
+
+    /** Deduplicate the landmarks observed twice in the frame (the first camera and observation wins) **/
+    std::sort(this->new_landmarks.begin(), this->new_landmarks.end());
+    const std::vector<NewLandmark>::iterator end = std::unique(this->new_landmarks.begin(), this->new_landmarks.end(),
+            NewLandmark::sameKey);
+
+    /** Single bulk insert stage. The initial values are cloned once, directly in the estimated values **/
+    for (std::vector<NewLandmark>::const_iterator it = this->new_landmarks.begin(); it != end; ++it)
+    {
+        this->estimate_values->insert(it->key, gtsam::Point3(this->workspaces[it->camera_idx].nav_points.col(it->column)));
+    }
+}
+
+gtsam::Cal3_S2Stereo::shared_ptr BackEnd::stereoCalibration(const frame_helper::StereoCalibration &calib) const
+{
+    return gtsam::Cal3_S2Stereo::shared_ptr(new gtsam::Cal3_S2Stereo(calib.camLeft.fx,
+                                                calib.camLeft.fy,
+                                                0.00,
+                                                calib.camLeft.cx,
+                                                calib.camLeft.cy,
+                                                calib.extrinsic.tx));
+}
+
+void BackEnd::reserveGraph(const size_t new_factors)
+{
+    const size_t required = this->factor_graph->size() + new_factors;
+    if (required > this->factor_graph_capacity)
+    {
+        /** Grow geometrically to amortize the reallocations **/
+        this->factor_graph_capacity = std::max(required, 2 * this->factor_graph_capacity);
+        this->factor_graph->reserve(this->factor_graph_capacity);
+    }
+}
+
+gtsam::Symbol BackEnd::landmarkSymbol(const boost::uuids::uuid &index) const
+{
+    /** The last 14 hexadecimal digits (7 bytes) of the UUID **/
+    std::uint64_t index_uint = 0;
+    for (boost::uuids::uuid::const_iterator it = index.end() - 7; it != index.end(); ++it)
+    {
+        index_uint = (index_uint << 8) | static_cast<std::uint64_t>(*it);
+    }
+    return gtsam::Symbol(this->landmark_key, index_uint);
+}
+
+void BackEnd::addCount(const StereoFactorsCount &count)
+{
+    this->backend_stats.frame_allocations += count.allocations;
+    this->backend_stats.rejected_landmarks += count.rejected_landmarks;
+}
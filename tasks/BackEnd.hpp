@@ -0,0 +1,519 @@
+#ifndef VSD_SLAM_BACK_END_HPP
+#define VSD_SLAM_BACK_END_HPP
+
+/** STD **/
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <new>
+
+/** Boost **/
+#include <boost/shared_ptr.hpp> /** shared pointers **/
+#include <boost/make_shared.hpp> /** allocate_shared **/
+#include <boost/pool/pool.hpp> /** Per-camera factor pools **/
+#include <boost/optional.hpp>
+#include <boost/uuid/uuid.hpp>
+
+/** Eigen **/
+#include <Eigen/Core> /** Core */
+#include <Eigen/Geometry> /** Transformations **/
+#include <Eigen/StdVector> /** For STL container with Eigen types **/
+#include <Eigen/Cholesky> /** LDLT for the landmarks cross-check **/
+
+/** GTSAM TYPES **/
+#include <gtsam/geometry/Pose3.h>
+#include <gtsam/geometry/Cal3_S2Stereo.h>
+#include <gtsam/nonlinear/Values.h>
+#include <gtsam/inference/Symbol.h>
+
+/** GTSAM Factors **/
+#include <gtsam/slam/BetweenFactor.h>
+#include <gtsam/nonlinear/NonlinearEquality.h>
+#include <gtsam/nonlinear/NonlinearFactorGraph.h>
+#include <gtsam/slam/StereoFactor.h>
+
+/** Base Types **/
+#include <base/Time.hpp>
+#include <base/samples/BodyState.hpp>
+#include <base/samples/RigidBodyState.hpp>
+
+/** Rock libraries **/
+#include <frame_helper/Calibration.h> /** Rock type for camera calibration parameters **/
+
+/** Visual stereo and back-end types **/
+#include "vsd_slam/vsd_slamTypes.hpp"
+
+/** Heap allocations counter **/
+#include "AllocationCounter.hpp"
+
+/** Persistent worker threads **/
+#include "WorkerPool.hpp"
+
+namespace vsd_slam {
+
+    /** Stereo factor **/
+    typedef gtsam::GenericStereoFactor<gtsam::Pose3, gtsam::Point3> StereoFactor;
+
+    /** Allocator out of a boost::pool owned by the caller. The pool is not
+     * thread-safe and has no lock: each camera allocates its factors from
+     * its own pool, and the factors are only released with the graph
+     * (with no factor construction running). Requests larger than the
+     * pool chunks go to operator new **/
+    template <typename T>
+    class PoolAllocator
+    {
+    public:
+        typedef T value_type;
+        typedef T* pointer;
+        typedef const T* const_pointer;
+        typedef T& reference;
+        typedef const T& const_reference;
+        typedef std::size_t size_type;
+        typedef std::ptrdiff_t difference_type;
+
+        template <typename U>
+        struct rebind
+        {
+            typedef PoolAllocator<U> other;
+        };
+
+        boost::pool<> *pool;
+
+        explicit PoolAllocator(boost::pool<> *pool)
+            : pool(pool)
+        {
+        }
+
+        template <typename U>
+        PoolAllocator(const PoolAllocator<U> &other)
+            : pool(other.pool)
+        {
+        }
+
+        pointer allocate(size_type n, const void * = 0)
+        {
+            if (n * sizeof(T) <= this->pool->get_requested_size())
+            {
+                void *p = this->pool->malloc();
+                if (p == NULL)
+                {
+                    throw std::bad_alloc();
+                }
+                return static_cast<pointer>(p);
+            }
+            return static_cast<pointer>(::operator new(n * sizeof(T)));
+        }
+
+        void deallocate(pointer p, size_type n)
+        {
+            if (n * sizeof(T) <= this->pool->get_requested_size())
+            {
+                this->pool->free(p);
+            }
+            else
+            {
+                ::operator delete(p);
+            }
+        }
+
+        void construct(pointer p, const T &value) { new (p) T(value); }
+
+        void destroy(pointer p) { p->~T(); }
+
+        size_type max_size() const { return std::numeric_limits<size_type>::max() / sizeof(T); }
+    };
+
+    template <typename T, typename U>
+    bool operator==(const PoolAllocator<T> &a, const PoolAllocator<U> &b) { return a.pool == b.pool; }
+
+    template <typename T, typename U>
+    bool operator!=(const PoolAllocator<T> &a, const PoolAllocator<U> &b) { return a.pool != b.pool; }
+
+    typedef PoolAllocator<StereoFactor> StereoFactorAllocator;
+
+    /** Chunk size of the factor pools: the factor and the shared_ptr
+     * control block of allocate_shared in a single chunk (16 bytes aligned) **/
+    static const size_t STEREO_FACTOR_CHUNK_SIZE = ((sizeof(StereoFactor) + 128 + 15) / 16) * 16;
+
+    /** Stereo camera of the rig **/
+    struct StereoCamera
+    {
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+        /** GTSAM stereo calibration **/
+        gtsam::Cal3_S2Stereo::shared_ptr calib;
+
+        /** Camera in reference camera (Treference_camera) **/
+        Eigen::Affine3d reference_camera_tf;
+
+        /** Camera in reference camera for the stereo factor (none for the reference camera) **/
+        boost::optional<gtsam::Pose3> body_P_sensor;
+    };
+
+    /** Counters of the factor construction of a camera **/
+    struct StereoFactorsCount
+    {
+        /** Heap allocations of a worker thread (the calling thread is counted with the frame) **/
+        unsigned int allocations;
+
+        /** New landmarks rejected by the triangulation cross-check **/
+        unsigned int rejected_landmarks;
+
+        StereoFactorsCount()
+            : allocations(0), rejected_landmarks(0)
+        {
+        }
+    };
+
+    /** Per-camera workspace of the factor construction. The buffers keep
+     * their capacity between frames, so that a warmed up back-end does not
+     * allocate for them **/
+    struct StereoFactorsWorkspace
+    {
+        /** Factors of the camera (only for a rig with several cameras) **/
+        gtsam::NonlinearFactorGraph graph;
+
+        /** Landmark keys of the processed features **/
+        std::vector<gtsam::Key> feature_keys;
+
+        /** Index in the frame of the features which are new landmarks **/
+        std::vector<size_t> new_features;
+
+        /** Whether the new landmark passed the triangulation cross-check **/
+        std::vector<char> accepted;
+
+        /** Keys of the accepted new landmarks. Their navigation frame
+         * points are the first columns of nav_points **/
+        std::vector<gtsam::Key> landmark_keys;
+
+        /** Triangulation buffers of the new landmarks (columns >= new landmarks) **/
+        Eigen::Matrix3Xd stereo_points, camera_points, nav_points;
+        Eigen::Array<double, 1, Eigen::Dynamic> disparity;
+
+        StereoFactorsCount count;
+    };
+
+    /** Accepted new landmark of a camera workspace **/
+    struct NewLandmark
+    {
+        gtsam::Key key;
+        size_t camera_idx;
+        size_t column; // Column of the workspace nav_points
+
+        NewLandmark(const gtsam::Key key, const size_t camera_idx, const size_t column)
+            : key(key), camera_idx(camera_idx), column(column)
+        {
+        }
+
+        /** By key, then in the camera and observation order **/
+        bool operator<(const NewLandmark &other) const
+        {
+            if (key != other.key) return key < other.key;
+            if (camera_idx != other.camera_idx) return camera_idx < other.camera_idx;
+            return column < other.column;
+        }
+
+        static bool sameKey(const NewLandmark &a, const NewLandmark &b)
+        {
+            return a.key == b.key;
+        }
+    };
+
+    /*! \class BackEnd
+     * \brief Visual stereo back-end: factor graph construction and
+     * optimization out of delta poses and stereo features.
+     *
+     * It has no dependency on the RTT runtime. The Task feeds it with the
+     * samples of the input ports and the transformations of the transformer.
+     */
+    class BackEnd
+    {
+    public:
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW //Structures having Eigen members
+
+    protected:
+
+        /******************************/
+        /*** Control Flow Variables ***/
+        /******************************/
+
+        /** Indices to identify poses and landmarks **/
+        unsigned long int pose_idx;
+
+        /** The back-end is behind the incoming samples **/
+        bool overloaded;
+
+        /** Number of delta pose samples pending to be integrated **/
+        unsigned int delta_pose_pending;
+
+        /** Non-keyframes seen while overloaded (for frames subsampling) **/
+        unsigned int shed_frame_counter;
+
+        /** Frames shed since the last pose (the next pose is linked with the odometry) **/
+        bool frames_shed;
+
+        /*******************************/
+        /*** Configuration Variables ***/
+        /*******************************/
+
+        /** Keys to identify poses and landmarks **/
+        char pose_key, landmark_key;
+
+        /** GTSAM stereo calibration **/
+        gtsam::Cal3_S2Stereo::shared_ptr stereo_calib;
+
+        /** Stereo cameras of the rig. The first one is the reference camera (calib_parameters) **/
+        std::vector<StereoCamera, Eigen::aligned_allocator<StereoCamera> > cameras;
+
+        /** Noise model of the stereo pixel measurements **/
+        gtsam::noiseModel::Isotropic::shared_ptr pixel_noise_model;
+
+        /** Initial number of factors reserved in the graph **/
+        size_t graph_capacity;
+
+        /** Landmark initialization configuration **/
+        vsd_slam::LandmarkConfiguration landmark_config;
+
+        /** Overload handling configuration **/
+        vsd_slam::OverloadConfiguration overload_config;
+
+        /******************************************/
+        /*** General Internal Storage Variables ***/
+        /******************************************/
+
+        /** Delta Pose estimation (coalesced increment in body frame) **/
+        base::samples::BodyState delta_pose;
+
+        /** Time of the last processed features sample **/
+        base::Time last_features_time;
+
+        /** Factor pool of each camera. Declared before the graph, which
+         * holds the factors, so that the pools are released after it **/
+        std::vector< boost::shared_ptr< boost::pool<> > > factor_pools;
+
+        /** Worker threads of the per-camera factor construction and of the
+         * triangulation of large frames **/
+        WorkerPool worker_pool;
+
+        /** GTSAM Factor graph **/
+        boost::shared_ptr<gtsam::NonlinearFactorGraph> factor_graph;
+
+        /** Reserved number of factors in the factor graph **/
+        size_t factor_graph_capacity;
+
+        /** Values of the estimated quantities: TO-DO move to envire graph **/
+        boost::shared_ptr<gtsam::Values> estimate_values;
+
+        /** Cumulative delta pose between features samples  **/
+        base::samples::BodyState cumulative_delta_pose;
+
+        /** Cumulative delta pose of the last pose (before the reset in addPose) **/
+        base::samples::BodyState pose_delta_pose;
+
+        /** Pre-integration pose with covariance **/
+        base::samples::BodyState pose_with_cov;
+
+        /** Transformation between body and sensor frame **/
+        base::samples::BodyState body_sensor_bs;
+
+        /** Factor construction workspace of each camera **/
+        std::vector<StereoFactorsWorkspace> workspaces;
+
+        /** New landmarks of the cameras to deduplicate before the insert **/
+        std::vector<NewLandmark> new_landmarks;
+
+        /** Allocations of the calling thread at the start of the frame **/
+        unsigned long long frame_allocations_start;
+
+        /** Back-end statistics **/
+        vsd_slam::BackEndStatistics backend_stats;
+
+    public:
+        BackEnd();
+
+        ~BackEnd();
+
+        /**@brief Configure the cameras of the rig, the noise model and the policies
+         */
+        void configure(const frame_helper::StereoCalibration &calib,
+                    const std::vector<vsd_slam::StereoRigCamera> &rig_cameras,
+                    const double pixel_sigma, const int graph_capacity,
+                    const vsd_slam::LandmarkConfiguration &landmark_config,
+                    const vsd_slam::OverloadConfiguration &overload_config);
+
+        /**@brief Release the graph, the values and the cameras
+         */
+        void cleanup();
+
+        /**@brief initialization with the first pose (Tworld_sensor) and Tbody_sensor
+         */
+        void initialization(const Eigen::Affine3d &tf, const Eigen::Affine3d &body_sensor_tf);
+
+        /**@brief Add a delta pose sample in body frame. It returns whether
+         * the pending increment should be integrated now (false while
+         * coalescing the delta poses of an overloaded back-end)
+         */
+        bool addDeltaPose(const base::samples::RigidBodyState &delta_pose_sample);
+
+        /**@brief Whether there are delta pose samples pending to be integrated
+         */
+        bool deltaPosePending() const;
+
+        /**@brief Integrate the pending delta pose in the cumulative delta pose
+         */
+        void integrateDeltaPose(const Eigen::Affine3d &body_sensor_tf);
+
+        /**@brief Start the statistics of a new features sample
+         */
+        void startFrame();
+
+        /**@brief Whether the image frame is a keyframe
+         */
+        bool isKeyFrame(const unsigned int img_idx) const;
+
+        /**@brief Number of features to skip between processed features. Zero
+         * in case the whole frame is shed by the overload policy.
+         */
+        unsigned int sheddingStride(const unsigned int img_idx);
+
+        /**@brief Account a frame shed by the overload policy
+         */
+        void shedFrame(const unsigned int features_size);
+
+        /**@brief Add a new pose with the cumulative delta pose. It returns the pose symbol
+         */
+        gtsam::Symbol addPose();
+
+        /**@brief Add the features of the cameras taken at the same time
+         * (frames[i] belongs to cameras[i]) to the pose
+         */
+        void addFeatures(const ::visual_stereo::ExteroFeatures *frames, const size_t number_cameras,
+                        const unsigned int feature_stride, const gtsam::Symbol &pose_symbol);
+
+        /** @brief Optimize
+         * */
+        void optimize();
+
+        /**@brief Update the processing backlog with the processing time of a features sample
+         */
+        void updateBacklog(const base::Time &timestamp, const double processing_time);
+
+        /**@brief Process the features of the cameras taken at the same time
+         * (frames[i] belongs to cameras[i]): overload policy, pending delta
+         * pose, new pose, stereo factors, optimization at the keyframes and
+         * backlog. It returns false in case the frame is shed by the overload
+         * policy (no new pose). The frame allocations are counted within this
+         * call only
+         */
+        bool processFeatures(const ::visual_stereo::ExteroFeatures *frames, const size_t number_cameras,
+                        const unsigned int img_idx, const base::Time &time, const Eigen::Affine3d &body_sensor_tf);
+
+        /**@brief Landmark symbol out of the feature UUID
+         */
+        gtsam::Symbol landmarkSymbol(const boost::uuids::uuid &index) const;
+
+        /**@brief Number of stereo cameras of the rig
+         */
+        size_t numberCameras() const { return this->cameras.size(); }
+
+        /**@brief Whether the back-end is behind the incoming samples
+         */
+        bool isOverloaded() const { return this->overloaded; }
+
+        /**@brief Symbol of the last pose
+         */
+        gtsam::Symbol poseSymbol() const { return gtsam::Symbol(this->pose_key, this->pose_idx); }
+
+        const gtsam::NonlinearFactorGraph& graph() const { return *(this->factor_graph); }
+
+        const gtsam::Values& values() const { return *(this->estimate_values); }
+
+        const base::samples::BodyState& deltaPose() const { return this->delta_pose; }
+
+        const base::samples::BodyState& cumulativeDeltaPose() const { return this->cumulative_delta_pose; }
+
+        const base::samples::BodyState& poseDeltaPose() const { return this->pose_delta_pose; }
+
+        const base::samples::BodyState& pose() const { return this->pose_with_cov; }
+
+        vsd_slam::BackEndStatistics& statistics() { return this->backend_stats; }
+
+        const vsd_slam::BackEndStatistics& statistics() const { return this->backend_stats; }
+
+    protected:
+
+        /** Context of the per-camera factor construction in the worker pool **/
+        struct StereoFactorsJob
+        {
+            BackEnd *back_end;
+            const ::visual_stereo::ExteroFeatures *frames;
+            unsigned int feature_stride;
+            const gtsam::Symbol *pose_symbol;
+        };
+
+        /** Context of the parallel triangulation in the worker pool **/
+        struct TriangulationJob
+        {
+            const BackEnd *back_end;
+            const StereoCamera *camera;
+            const Eigen::Affine3d *nav_camera_tf;
+            const ::visual_stereo::ExteroFeatures *frame;
+            StereoFactorsWorkspace *workspace;
+            size_t chunk;
+            size_t number_landmarks;
+        };
+
+        /**@brief Worker pool job: factor construction of the camera camera_idx
+         */
+        static void stereoFactorsTask(void *context, const size_t camera_idx);
+
+        /**@brief Worker pool job: triangulation of the chunk chunk_idx of the new landmarks
+         */
+        static void triangulationTask(void *context, const size_t chunk_idx);
+
+        /**@brief Construct the stereo factors of a camera and triangulate
+         * its new landmarks in the workspace. It only reads the shared graph
+         * and values and allocates from the pool of the camera (safe to run
+         * in parallel for different cameras). The triangulation only uses
+         * the worker pool when parallel (i.e.: not called from a worker)
+         */
+        void stereoFactors(const size_t camera_idx, const ::visual_stereo::ExteroFeatures &frame,
+                        const unsigned int feature_stride, const gtsam::Symbol &pose_symbol,
+                        gtsam::NonlinearFactorGraph &graph, StereoFactorsWorkspace &workspace,
+                        const bool parallel);
+
+        /**@brief Batch initialization of the new landmarks. It triangulates
+         * the stereo points, cross-checks them against the front-end points
+         * and transforms the accepted ones to the navigation frame
+         */
+        void landmarksInitialization(const StereoCamera &camera, const Eigen::Affine3d &nav_camera_tf,
+                                const ::visual_stereo::ExteroFeatures &frame, StereoFactorsWorkspace &workspace,
+                                const bool parallel);
+
+        /**@brief Stereo triangulation of the new landmarks in [begin, end)
+         */
+        void triangulationKernel(const StereoCamera &camera, const Eigen::Affine3d &nav_camera_tf,
+                            const ::visual_stereo::ExteroFeatures &frame, const size_t begin, const size_t end,
+                            StereoFactorsWorkspace &workspace) const;
+
+        /**@brief Deduplicate the accepted new landmarks of the cameras and
+         * insert them in the estimated values
+         */
+        void insertLandmarks(const size_t number_cameras);
+
+        /**@brief GTSAM stereo calibration out of the frame_helper calibration
+         */
+        gtsam::Cal3_S2Stereo::shared_ptr stereoCalibration(const frame_helper::StereoCalibration &calib) const;
+
+        /**@brief Reserve the factor graph capacity for the new factors
+         */
+        void reserveGraph(const size_t new_factors);
+
+        /**@brief Add the counters of the factor construction to the statistics
+         */
+        void addCount(const StereoFactorsCount &count);
+    };
+}
+
+#endif
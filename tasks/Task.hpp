@@ -13,36 +13,22 @@
 #include <stdlib.h>
 
 /** Boost **/
-#include <boost/shared_ptr.hpp> /** shared pointers **/
 #include <boost/uuid/uuid_io.hpp>
 
 /** Eigen **/
 #include <Eigen/Core> /** Core */
-#include <Eigen/StdVector> /** For STL container with Eigen types **/
-
-/** GTSAM TYPES **/
-#include <gtsam/geometry/Pose3.h>
-#include <gtsam/geometry/Cal3_S2Stereo.h>
-#include <gtsam/nonlinear/Values.h>
-#include <gtsam/inference/Symbol.h>
-
-/** GTSAM Factors **/
-#include <gtsam/slam/PriorFactor.h>
-#include <gtsam/slam/BetweenFactor.h>
-#include <gtsam/nonlinear/NonlinearEquality.h>
-#include <gtsam/nonlinear/NonlinearFactorGraph.h>
-#include <gtsam/slam/StereoFactor.h>
-
 
 /** Base Types **/
 #include <base/samples/BodyState.hpp>
 #include <base/samples/RigidBodyState.hpp>
 #include <base/samples/Pointcloud.hpp>
-#include <gtsam/nonlinear/LevenbergMarquardtOptimizer.h>
 
 /** Rock libraries **/
 #include <frame_helper/Calibration.h> /** Rock type for camera calibration parameters **/
 
+/** Visual stereo back-end **/
+#include "BackEnd.hpp"
+
 namespace vsd_slam {
 
     /*! \class Task 
@@ -76,47 +62,19 @@ tasks/Task.cpp, and will be put in the vsd_slam namespace.
         /******************************/
         bool init_flag;
 
-        /** Indices to identify poses and landmarks **/
-        unsigned long int pose_idx;
-
         /**************************/
         /*** Property Variables ***/
         /**************************/
 
-        /** Keys to identify poses and landmarks **/
-        char pose_key, landmark_key;
-
         /** Intrinsic and extrinsic parameters for the pinhole camera model **/
         frame_helper::StereoCalibration camera_calib;
 
-        /** GTSAM stereo calibration **/
-        gtsam::Cal3_S2Stereo::shared_ptr stereo_calib;
-
-        /**************************/
-        /** Input port variables **/
-        /**************************/
-
-        /** Delta Pose estimation **/
-        ::base::samples::BodyState delta_pose;
-
         /******************************************/
         /*** General Internal Storage Variables ***/
         /******************************************/
 
-        /** GTSAM Factor graph **/
-        boost::shared_ptr<gtsam::NonlinearFactorGraph> factor_graph;
-
-        /** Values of the estimated quantities: TO-DO move to envire graph **/
-        boost::shared_ptr<gtsam::Values> estimate_values;
-
-        /** Cumulative delta pose between features samples  **/
-        base::samples::BodyState cumulative_delta_pose;
-
-        /** Pre-integration pose with covariance **/
-        base::samples::BodyState pose_with_cov;
-
-        /** Transformation between body and sensor frame **/
-        base::samples::BodyState body_sensor_bs;
+        /** Factor graph construction and optimization **/
+        BackEnd back_end;
 
         /***************************/
         /** Output port variables **/
@@ -130,6 +88,8 @@ tasks/Task.cpp, and will be put in the vsd_slam namespace.
 
         virtual void visual_features_samplesTransformerCallback(const base::Time &ts, const ::visual_stereo::ExteroFeatures &visual_features_samples_sample);
 
+        virtual void rig_features_samplesTransformerCallback(const base::Time &ts, const ::vsd_slam::RigFeatures &rig_features_samples_sample);
+
     public:
         /** TaskContext constructor for Task
          * \param name Name of the task. This name needs to be unique to make it identifiable via nameservices.
@@ -206,21 +166,31 @@ tasks/Task.cpp, and will be put in the vsd_slam namespace.
          */
         void cleanupHook();
 
-        /**@brief initialization
+        /**@brief Get the transformation Tbody_sensor
+         */
+        bool bodySensorTransform(const base::Time &ts, Eigen::Affine3d &body_sensor_tf);
+
+        /**@brief Integrate the pending delta pose in the cumulative delta pose
          */
-        void initialization(Eigen::Affine3d &tf);
+        void integrateDeltaPose(const base::Time &ts);
 
-        /**@brief Output port the odometry pose
+        /**@brief Process the features of the cameras taken at the same time
+         * (frames[i] belongs to cameras[i]) and add them to the same pose
          */
-        void odo_poseOutputPort(const base::Time &timestamp);
+        void featuresProcessing(const base::Time &ts, const base::Time &time, const unsigned int img_idx,
+                            const ::visual_stereo::ExteroFeatures *frames, const size_t number_cameras);
+
+        /**@brief Output port the back-end statistics (processing time, backlog and shed samples)
+         */
+        void backlogOutputPort();
+
+        /**@brief Output port the odometry pose (cumulative delta pose since the last pose)
+         */
+        void odo_poseOutputPort(const base::Time &timestamp, const base::samples::BodyState &cumulative_delta_pose);
 
         /**@brief Output port the slam pose
         * */
         void slam_poseOutputPort(const base::Time &timestamp, const gtsam::Symbol &symbol);
-
-        /** @brief Optimize
-         * */
-        void optimize();
     };
 }
 
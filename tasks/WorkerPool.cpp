@@ -0,0 +1,147 @@
+#include "WorkerPool.hpp"
+
+#include <stdexcept>
+
+using namespace vsd_slam;
+
+WorkerPool::WorkerPool()
+    : job(NULL), context(NULL), number_tasks(0), generation(0), pending(0), stopping(false)
+{
+}
+
+WorkerPool::~WorkerPool()
+{
+    this->stop();
+}
+
+void WorkerPool::start(const size_t number_workers)
+{
+    this->stop();
+
+    /** The new workers only run the jobs after this one **/
+    this->stopping = false;
+    this->workers.reserve(number_workers);
+    for (size_t i = 0; i < number_workers; ++i)
+    {
+        this->workers.push_back(std::thread(&WorkerPool::workerLoop, this, i, this->generation));
+    }
+}
+
+void WorkerPool::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->work_condition.notify_all();
+
+    for (size_t i = 0; i < this->workers.size(); ++i)
+    {
+        this->workers[i].join();
+    }
+    this->workers.clear();
+}
+
+void WorkerPool::run(Job job, void *context, const size_t number_tasks)
+{
+    if (number_tasks == 0)
+    {
+        return;
+    }
+    if (number_tasks > this->concurrency())
+    {
+        throw std::invalid_argument("[WORKER_POOL] more tasks than worker threads");
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->job = job;
+        this->context = context;
+        this->number_tasks = number_tasks;
+        this->pending = number_tasks - 1;
+        this->error = std::exception_ptr();
+        this->generation++;
+    }
+    if (number_tasks > 1)
+    {
+        this->work_condition.notify_all();
+    }
+
+    {
+        /** The workers use the context of the caller: wait for them
+         * before leaving, also when the task of this thread throws **/
+        struct WaitGuard
+        {
+            WorkerPool &pool;
+            ~WaitGuard() { pool.wait(); }
+        } guard = {*this};
+
+        job(context, 0);
+    }
+
+    /** First exception of the workers **/
+    if (this->error)
+    {
+        std::exception_ptr error;
+        std::swap(error, this->error);
+        std::rethrow_exception(error);
+    }
+}
+
+void WorkerPool::wait()
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (this->pending > 0)
+    {
+        this->done_condition.wait(lock);
+    }
+}
+
+void WorkerPool::workerLoop(const size_t worker_idx, unsigned long long seen_generation)
+{
+    const size_t task_idx = worker_idx + 1;
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (true)
+    {
+        while (!this->stopping && this->generation == seen_generation)
+        {
+            this->work_condition.wait(lock);
+        }
+        if (this->stopping)
+        {
+            return;
+        }
+        seen_generation = this->generation;
+
+        /** No task for this worker in the current job **/
+        if (task_idx >= this->number_tasks)
+        {
+            continue;
+        }
+
+        Job job = this->job;
+        void *context = this->context;
+        lock.unlock();
+
+        std::exception_ptr task_error;
+        try
+        {
+            job(context, task_idx);
+        }
+        catch (...)
+        {
+            task_error = std::current_exception();
+        }
+
+        lock.lock();
+        if (task_error && !this->error)
+        {
+            this->error = task_error;
+        }
+        if (--this->pending == 0)
+        {
+            this->done_condition.notify_all();
+        }
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef VSD_SLAM_WORKER_POOL_HPP
+#define VSD_SLAM_WORKER_POOL_HPP
+
+/** STD **/
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+namespace vsd_slam
+{
+    /*! \class WorkerPool
+     * \brief Persistent worker threads for the per-frame parallel work.
+     *
+     * The threads are created once (configuration) and wait for jobs. A
+     * job is a plain function with a context pointer, so that running it
+     * does not allocate.
+     */
+    class WorkerPool
+    {
+    public:
+        /** Job function: it runs the task task_idx of the context **/
+        typedef void (*Job)(void *context, const size_t task_idx);
+
+    protected:
+
+        std::vector<std::thread> workers;
+
+        std::mutex mutex;
+        std::condition_variable work_condition;
+        std::condition_variable done_condition;
+
+        /** Current job and its number of tasks **/
+        Job job;
+        void *context;
+        size_t number_tasks;
+
+        /** Job counter (the workers wait for a new one) **/
+        unsigned long long generation;
+
+        /** Tasks of the workers still running **/
+        size_t pending;
+
+        /** First exception of the workers in the current job **/
+        std::exception_ptr error;
+
+        bool stopping;
+
+    public:
+        WorkerPool();
+
+        ~WorkerPool();
+
+        /**@brief Start the worker threads. The pool runs 1 + number_workers
+         * tasks at once (the calling thread runs the first one)
+         */
+        void start(const size_t number_workers);
+
+        /**@brief Stop and join the worker threads
+         */
+        void stop();
+
+        /**@brief Number of tasks the pool runs at once (workers and calling thread)
+         */
+        size_t concurrency() const { return this->workers.size() + 1; }
+
+        /**@brief Run the tasks [0, number_tasks) of the job and wait for
+         * them. Task 0 runs in the calling thread and task i in the worker
+         * i-1, so number_tasks cannot exceed concurrency(). It always
+         * waits for every task before returning or rethrowing the first
+         * exception of a task. It is not reentrant: do not call it from a
+         * task.
+         */
+        void run(Job job, void *context, const size_t number_tasks);
+
+    protected:
+
+        /**@brief Wait until the workers finished the tasks of the current job
+         */
+        void wait();
+
+        /**@brief Loop of the worker thread worker_idx. It waits for the
+         * jobs after seen_generation
+         */
+        void workerLoop(const size_t worker_idx, unsigned long long seen_generation);
+    };
+}
+
+#endif
@@ -0,0 +1,706 @@
+#define BOOST_TEST_MODULE vsd_slam
+#include <boost/test/unit_test.hpp>
+
+/** STD **/
+#include <vector>
+#include <map>
+#include <cmath>
+#include <random>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <thread>
+
+#include "BackEnd.hpp"
+
+using namespace vsd_slam;
+
+/***********************************************/
+/** Synthetic scene and stereo camera         **/
+/***********************************************/
+namespace
+{
+    /** Stereo camera (pixels and meters) **/
+    const double FX = 500.00, FY = 500.00, CX = 320.00, CY = 240.00;
+    const double BASELINE = 0.25, WIDTH = 640.00, HEIGHT = 480.00;
+    const double MIN_DEPTH = 1.00, MAX_DEPTH = 20.00;
+    const double PIXEL_SIGMA = 0.30;
+
+    /** Scene: landmarks in a corridor along the trajectory **/
+    const size_t NUMBER_LANDMARKS = 1000;
+    const unsigned int NUMBER_FRAMES = 100; /** The last frame is a keyframe (optimization) **/
+    const double FRAME_PERIOD = 0.10, STEP = 0.20;
+
+    /** Delta pose noise (per sample) **/
+    const double DELTA_POSITION_SIGMA = 0.005, DELTA_ORIENTATION_SIGMA = 0.001;
+
+    /** Accuracy thresholds on the optimized trajectory (20 meters): twice the largest RMSE of the
+     * single camera (seed 42) and rig (seed 7) scenes, rounded up. Observed with the same scenes and
+     * factor graph solved to convergence: ATE 0.0112 / 0.0154 m, RPE 0.0021 / 0.0012 m and
+     * 0.00026 / 0.00019 rad (dead reckoning alone: ATE 0.098 / 0.060 m) **/
+    const double ATE_MAX = 0.035; /** Absolute trajectory error RMSE [m] **/
+    const double RPE_POSITION_MAX = 0.005; /** Relative pose error RMSE between frames [m] **/
+    const double RPE_ORIENTATION_MAX = 0.0006; /** Relative pose error RMSE between frames [rad] **/
+
+    /** Keyframe position error with the non-keyframes shed (seed 3): observed 0.020 and 0.041 m **/
+    const double SHED_KEYFRAME_POSITION_MAX = 0.10; /** [m] **/
+
+    /** Processing time budget of the frames which are not keyframes (keyframes optimize): half the
+     * input period for the 95th percentile, so that the back-end keeps up with the samples. Debug
+     * builds are given four times the budget **/
+    #ifdef NDEBUG
+    const double FRAME_TIME_BUDGET = 0.50 * FRAME_PERIOD; /** [s] **/
+    #else
+    const double FRAME_TIME_BUDGET = 2.00 * FRAME_PERIOD; /** [s] **/
+    #endif
+    const double FRAME_TIME_PERCENTILE = 0.95;
+
+    /** Allocations budget of the frames which are not keyframes. Each stereo factor allocates its
+     * keys vector; the factor, the values and the map nodes come from pools, which only allocate
+     * when they grow (a few times per run), as do the graph and the workspaces. The overhead is
+     * four times those growth events per frame **/
+    const unsigned int FRAME_ALLOCATIONS_PER_FACTOR = 1;
+    const unsigned int FRAME_ALLOCATIONS_OVERHEAD = 16;
+    const unsigned int WARM_UP_FRAMES = 5; /** Frames growing the workspaces and the pools **/
+
+    struct Scene
+    {
+        std::vector<Eigen::Vector3d, Eigen::aligned_allocator<Eigen::Vector3d> > landmarks;
+        std::vector<Eigen::Affine3d, Eigen::aligned_allocator<Eigen::Affine3d> > trajectory; /** Tnav_camera of each frame **/
+    };
+
+    struct FrameStatistics
+    {
+        double processing_time;
+        unsigned int allocations;
+        unsigned int new_factors;
+        bool keyframe;
+    };
+
+    frame_helper::StereoCalibration stereoCalibration()
+    {
+        frame_helper::StereoCalibration calib;
+        calib.camLeft.fx = FX;
+        calib.camLeft.fy = FY;
+        calib.camLeft.cx = CX;
+        calib.camLeft.cy = CY;
+        calib.extrinsic.tx = BASELINE;
+        return calib;
+    }
+
+    /** UUID with the landmark id in its last 7 bytes (see BackEnd::landmarkSymbol) **/
+    boost::uuids::uuid landmarkIndex(const std::uint64_t id)
+    {
+        boost::uuids::uuid index;
+        std::fill(index.begin(), index.end(), 0);
+        for (size_t i = 0; i < 7; ++i)
+        {
+            index.data[15 - i] = static_cast<std::uint8_t>(id >> (8 * i));
+        }
+        return index;
+    }
+
+    /** Ground truth camera pose of the frame k: forward along z with a lateral sine and a slow yaw **/
+    Eigen::Affine3d groundTruthPose(const unsigned int k)
+    {
+        Eigen::Affine3d tf (Eigen::AngleAxisd(0.20 * std::sin(0.05 * k), Eigen::Vector3d::UnitY()));
+        tf.translation() << 0.50 * std::sin(0.05 * k), 0.00, STEP * k;
+        return tf;
+    }
+
+    Scene syntheticScene(std::mt19937 &generator)
+    {
+        Scene scene;
+        std::uniform_real_distribution<double> x(-8.00, 8.00), y(-3.00, 3.00), z(3.00, STEP * NUMBER_FRAMES + MAX_DEPTH);
+        for (size_t i = 0; i < NUMBER_LANDMARKS; ++i)
+        {
+            scene.landmarks.push_back(Eigen::Vector3d(x(generator), y(generator), z(generator)));
+        }
+        for (unsigned int k = 0; k <= NUMBER_FRAMES; ++k)
+        {
+            scene.trajectory.push_back(groundTruthPose(k));
+        }
+        return scene;
+    }
+
+    /** Noisy stereo features of the landmarks seen by a camera (Tnav_camera) **/
+    visual_stereo::ExteroFeatures stereoFeatures(const Scene &scene, const Eigen::Affine3d &nav_camera_tf,
+                                            const unsigned int img_idx, std::mt19937 &generator)
+    {
+        std::normal_distribution<double> pixel_noise(0.00, PIXEL_SIGMA);
+        visual_stereo::ExteroFeatures frame;
+        frame.time = base::Time::fromSeconds(FRAME_PERIOD * img_idx);
+        frame.img_idx = img_idx;
+
+        const Eigen::Affine3d camera_nav_tf (nav_camera_tf.inverse());
+        for (size_t i = 0; i < scene.landmarks.size(); ++i)
+        {
+            const Eigen::Vector3d point (camera_nav_tf * scene.landmarks[i]);
+            if (point.z() < MIN_DEPTH || point.z() > MAX_DEPTH)
+            {
+                continue;
+            }
+
+            const double u_left = FX * point.x() / point.z() + CX + pixel_noise(generator);
+            const double u_right = u_left - FX * BASELINE / point.z() + pixel_noise(generator);
+            const double v = FY * point.y() / point.z() + CY + pixel_noise(generator);
+            if (u_right < 0.00 || u_left >= WIDTH || v < 0.00 || v >= HEIGHT || u_left - u_right <= 0.00)
+            {
+                continue;
+            }
+
+            /** Front-end point and covariance out of the noisy stereo point **/
+            visual_stereo::Feature feature;
+            feature.index = landmarkIndex(i);
+            feature.stereo_point << u_left, u_right, v;
+            const double disparity = u_left - u_right;
+            const double depth = FX * BASELINE / disparity;
+            feature.point_3d << (u_left - CX) * depth / FX, (v - CY) * depth / FY, depth;
+
+            Eigen::Matrix3d jacobian; /** d(x, y, z) / d(u_left, u_right, v) **/
+            jacobian << depth / FX - (u_left - CX) * depth / (FX * disparity), (u_left - CX) * depth / (FX * disparity), 0.00,
+                     -(v - CY) * depth / (FY * disparity), (v - CY) * depth / (FY * disparity), depth / FY,
+                     -depth / disparity, depth / disparity, 0.00;
+            feature.cov_3d = PIXEL_SIGMA * PIXEL_SIGMA * jacobian * jacobian.transpose();
+            frame.features.push_back(feature);
+        }
+        return frame;
+    }
+
+    /** Noisy delta pose in body frame (body is the camera) between the frames k-1 and k **/
+    base::samples::RigidBodyState deltaPose(const Scene &scene, const unsigned int k, std::mt19937 &generator)
+    {
+        std::normal_distribution<double> position_noise(0.00, DELTA_POSITION_SIGMA);
+        std::normal_distribution<double> orientation_noise(0.00, DELTA_ORIENTATION_SIGMA);
+
+        Eigen::Affine3d delta_tf (scene.trajectory[k-1].inverse() * scene.trajectory[k]);
+        delta_tf.translation() += Eigen::Vector3d(position_noise(generator), position_noise(generator), position_noise(generator));
+        const Eigen::Vector3d rotation_noise (orientation_noise(generator), orientation_noise(generator), orientation_noise(generator));
+        delta_tf.linear() = delta_tf.linear() * Eigen::AngleAxisd(rotation_noise.norm(), rotation_noise.normalized()).toRotationMatrix();
+
+        base::samples::RigidBodyState delta_pose;
+        delta_pose.time = base::Time::fromSeconds(FRAME_PERIOD * k);
+        delta_pose.setTransform(delta_tf);
+        delta_pose.cov_position = DELTA_POSITION_SIGMA * DELTA_POSITION_SIGMA * base::Matrix3d::Identity();
+        delta_pose.cov_orientation = DELTA_ORIENTATION_SIGMA * DELTA_ORIENTATION_SIGMA * base::Matrix3d::Identity();
+        delta_pose.velocity = delta_tf.translation() / FRAME_PERIOD;
+        delta_pose.cov_velocity = delta_pose.cov_position / (FRAME_PERIOD * FRAME_PERIOD);
+        delta_pose.angular_velocity.setZero();
+        delta_pose.cov_angular_velocity = delta_pose.cov_orientation / (FRAME_PERIOD * FRAME_PERIOD);
+        return delta_pose;
+    }
+
+    /** Second camera of the rig 0.4 meters to the right: most landmarks are new in both cameras at once **/
+    StereoRigCamera rigCamera()
+    {
+        StereoRigCamera rig_camera;
+        rig_camera.calib = stereoCalibration();
+        rig_camera.reference_camera.position << 0.40, 0.00, 0.00;
+        rig_camera.reference_camera.orientation.setIdentity();
+        return rig_camera;
+    }
+
+    /** Stereo factors of each landmark in the graph **/
+    std::map<gtsam::Key, unsigned int> landmarkFactors(const BackEnd &back_end)
+    {
+        std::map<gtsam::Key, unsigned int> landmark_factors;
+        const gtsam::NonlinearFactorGraph &graph(back_end.graph());
+        for (size_t i = 0; i < graph.size(); ++i)
+        {
+            boost::shared_ptr<StereoFactor> factor = boost::dynamic_pointer_cast<StereoFactor>(graph[i]);
+            if (factor)
+            {
+                landmark_factors[factor->keys()[1]]++;
+            }
+        }
+        return landmark_factors;
+    }
+
+    /** Every landmark with factors has a value and there is no other landmark value **/
+    void checkLandmarkValues(const BackEnd &back_end, const std::map<gtsam::Key, unsigned int> &landmark_factors)
+    {
+        size_t landmark_values = 0;
+        const gtsam::KeyVector keys = back_end.values().keys();
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            if (gtsam::Symbol(keys[i]).chr() == 'l')
+            {
+                landmark_values++;
+            }
+        }
+        BOOST_CHECK_EQUAL(landmark_values, landmark_factors.size());
+
+        for (std::map<gtsam::Key, unsigned int>::const_iterator it = landmark_factors.begin(); it != landmark_factors.end(); ++it)
+        {
+            BOOST_CHECK(back_end.values().exists(it->first));
+        }
+    }
+
+    void configureBackEnd(BackEnd &back_end, const std::vector<StereoRigCamera> &rig_cameras,
+                    const OverloadConfiguration &overload_config = OverloadConfiguration(),
+                    const LandmarkConfiguration &landmark_config = LandmarkConfiguration())
+    {
+        back_end.configure(stereoCalibration(), rig_cameras, PIXEL_SIGMA, 1000,
+                landmark_config, overload_config);
+
+        /** The first pose is the ground truth (identity) and the body is the camera **/
+        back_end.initialization(Eigen::Affine3d::Identity(), Eigen::Affine3d::Identity());
+    }
+
+    /** Features sample processing with the same back-end call as the Task **/
+    FrameStatistics processFrame(BackEnd &back_end, const visual_stereo::ExteroFeatures *frames,
+                            const size_t number_cameras, const unsigned int img_idx)
+    {
+        const size_t factors = back_end.graph().size();
+
+        FrameStatistics frame_stats;
+        frame_stats.keyframe = back_end.isKeyFrame(img_idx);
+        back_end.processFeatures(frames, number_cameras, img_idx, frames[0].time, Eigen::Affine3d::Identity());
+        frame_stats.processing_time = back_end.statistics().processing_time;
+        frame_stats.allocations = back_end.statistics().frame_allocations;
+        frame_stats.new_factors = back_end.graph().size() - factors;
+        return frame_stats;
+    }
+
+    /** Run the trajectory of the scene with a rig of cameras (Treference_camera) **/
+    std::vector<FrameStatistics> runTrajectory(BackEnd &back_end, const Scene &scene,
+                                        const std::vector<Eigen::Affine3d, Eigen::aligned_allocator<Eigen::Affine3d> > &rig,
+                                        std::mt19937 &generator)
+    {
+        std::vector<FrameStatistics> frames_stats;
+        for (unsigned int k = 1; k <= NUMBER_FRAMES; ++k)
+        {
+            /** Delta pose samples arrive before the features of the frame **/
+            if (back_end.addDeltaPose(deltaPose(scene, k, generator)))
+            {
+                back_end.integrateDeltaPose(Eigen::Affine3d::Identity());
+            }
+
+            std::vector<visual_stereo::ExteroFeatures> frames;
+            for (size_t c = 0; c < rig.size(); ++c)
+            {
+                frames.push_back(stereoFeatures(scene, scene.trajectory[k] * rig[c], k, generator));
+            }
+            frames_stats.push_back(processFrame(back_end, &frames[0], frames.size(), k));
+        }
+        return frames_stats;
+    }
+
+    Eigen::Affine3d estimatedPose(const BackEnd &back_end, const unsigned int k)
+    {
+        return Eigen::Affine3d(back_end.values().at<gtsam::Pose3>(gtsam::Symbol('x', k)).matrix());
+    }
+
+    /** Trajectory error against the ground truth (the first pose is fixed, no alignment) **/
+    void checkTrajectoryError(const BackEnd &back_end, const Scene &scene)
+    {
+        double ate = 0.00, rpe_position = 0.00, rpe_orientation = 0.00;
+        for (unsigned int k = 1; k <= NUMBER_FRAMES; ++k)
+        {
+            const Eigen::Affine3d estimate (estimatedPose(back_end, k));
+            ate += (estimate.translation() - scene.trajectory[k].translation()).squaredNorm();
+
+            const Eigen::Affine3d delta_estimate (estimatedPose(back_end, k-1).inverse() * estimate);
+            const Eigen::Affine3d delta_truth (scene.trajectory[k-1].inverse() * scene.trajectory[k]);
+            const Eigen::Affine3d delta_error (delta_truth.inverse() * delta_estimate);
+            rpe_position += delta_error.translation().squaredNorm();
+            rpe_orientation += std::pow(Eigen::AngleAxisd(delta_error.rotation()).angle(), 2);
+        }
+        ate = std::sqrt(ate / NUMBER_FRAMES);
+        rpe_position = std::sqrt(rpe_position / NUMBER_FRAMES);
+        rpe_orientation = std::sqrt(rpe_orientation / NUMBER_FRAMES);
+
+        BOOST_TEST_MESSAGE("ATE " << ate << " [m] RPE " << rpe_position << " [m] " << rpe_orientation << " [rad]");
+        BOOST_CHECK_LT(ate, ATE_MAX);
+        BOOST_CHECK_LT(rpe_position, RPE_POSITION_MAX);
+        BOOST_CHECK_LT(rpe_orientation, RPE_ORIENTATION_MAX);
+    }
+
+    /** Time and allocations budget of the frames which are not keyframes **/
+    void checkFrameBudgets(const std::vector<FrameStatistics> &frames_stats)
+    {
+        std::vector<double> processing_times;
+        unsigned int max_allocations = 0, max_new_factors = 0;
+        for (size_t i = WARM_UP_FRAMES; i < frames_stats.size(); ++i)
+        {
+            const FrameStatistics &frame_stats(frames_stats[i]);
+            if (frame_stats.keyframe)
+            {
+                continue;
+            }
+
+            processing_times.push_back(frame_stats.processing_time);
+            max_allocations = std::max(max_allocations, frame_stats.allocations);
+            max_new_factors = std::max(max_new_factors, frame_stats.new_factors);
+            BOOST_CHECK_LE(frame_stats.allocations,
+                    FRAME_ALLOCATIONS_PER_FACTOR * frame_stats.new_factors + FRAME_ALLOCATIONS_OVERHEAD);
+        }
+
+        BOOST_TEST_MESSAGE("Frame allocations " << max_allocations << " new factors " << max_new_factors << " (maximum)");
+
+        /** Percentile of the processing time (a busy machine delays a few frames) **/
+        BOOST_REQUIRE(!processing_times.empty());
+        std::vector<double>::iterator percentile = processing_times.begin() +
+            static_cast<size_t>(FRAME_TIME_PERCENTILE * (processing_times.size() - 1));
+        std::nth_element(processing_times.begin(), percentile, processing_times.end());
+        BOOST_TEST_MESSAGE("Processing time percentile " << *percentile << " [s]");
+        BOOST_CHECK_LT(*percentile, FRAME_TIME_BUDGET);
+    }
+}
+
+/***********************************************/
+/** Building blocks                           **/
+/***********************************************/
+
+BOOST_AUTO_TEST_CASE(allocations_are_counted)
+{
+    BOOST_REQUIRE(allocationCounting());
+
+    const unsigned long long allocations = allocationCount();
+    std::vector<double> buffer(100);
+    Eigen::Matrix3Xd points(3, 100);
+    const unsigned long long counted = allocationCount() - allocations;
+
+    /** The buffers escape (the allocations cannot be elided) **/
+    BOOST_TEST_MESSAGE("Buffers " << buffer.data() << " " << points.data());
+    BOOST_CHECK_GE(counted, 2u);
+}
+
+BOOST_AUTO_TEST_CASE(landmark_symbol_is_the_uuid_last_seven_bytes)
+{
+    BackEnd back_end;
+    boost::uuids::uuid index = landmarkIndex(0x05000000000102ULL);
+    index.data[8] = 0xff; /** Not part of the symbol **/
+
+    const gtsam::Symbol symbol = back_end.landmarkSymbol(index);
+    BOOST_CHECK_EQUAL(symbol.chr(), 'l');
+    BOOST_CHECK_EQUAL(symbol.index(), 0x05000000000102ULL);
+}
+
+BOOST_AUTO_TEST_CASE(backlog_and_shedding_stride)
+{
+    OverloadConfiguration overload_config;
+    overload_config.shedding_policy = SHED_SUBSAMPLE_FEATURES;
+    overload_config.subsample_factor = 3;
+    overload_config.max_backlog = 0.00;
+
+    BackEnd back_end;
+    configureBackEnd(back_end, std::vector<StereoRigCamera>(), overload_config);
+    BOOST_CHECK_EQUAL(back_end.sheddingStride(1), 1u);
+
+    /** The processing takes longer than the period **/
+    back_end.updateBacklog(base::Time::fromSeconds(0.00), 0.01);
+    back_end.updateBacklog(base::Time::fromSeconds(0.10), 0.50);
+    BOOST_CHECK_CLOSE(back_end.statistics().backlog, 0.40, 1e-6);
+    BOOST_CHECK(back_end.isOverloaded());
+    BOOST_CHECK_EQUAL(back_end.sheddingStride(1), 3u);
+    BOOST_CHECK_EQUAL(back_end.sheddingStride(50), 1u); /** Keyframe **/
+
+    /** Coalesced delta poses while overloaded **/
+    base::samples::RigidBodyState delta_pose;
+    delta_pose.initUnknown();
+    delta_pose.position << 0.00, 0.00, 0.10;
+    delta_pose.cov_position = 1e-6 * base::Matrix3d::Identity();
+    delta_pose.cov_orientation = 1e-6 * base::Matrix3d::Identity();
+    delta_pose.cov_velocity = 1e-6 * base::Matrix3d::Identity();
+    delta_pose.cov_angular_velocity = 1e-6 * base::Matrix3d::Identity();
+    BOOST_CHECK(!back_end.addDeltaPose(delta_pose));
+    BOOST_CHECK(!back_end.addDeltaPose(delta_pose));
+    BOOST_CHECK_EQUAL(back_end.statistics().coalesced_delta_poses, 1u);
+    BOOST_REQUIRE(back_end.deltaPosePending());
+    back_end.integrateDeltaPose(Eigen::Affine3d::Identity());
+    BOOST_CHECK_CLOSE(back_end.cumulativeDeltaPose().position().z(), 0.20, 1e-6);
+
+    /** The backlog drains while the processing is faster than the period **/
+    back_end.updateBacklog(base::Time::fromSeconds(0.20), 0.01);
+    BOOST_CHECK_CLOSE(back_end.statistics().backlog, 0.31, 1e-6);
+    for (unsigned int i = 3; i < 10; ++i)
+    {
+        back_end.updateBacklog(base::Time::fromSeconds(0.10 * i), 0.01);
+    }
+    BOOST_CHECK_EQUAL(back_end.statistics().backlog, 0.00);
+    BOOST_CHECK(!back_end.isOverloaded());
+    BOOST_CHECK_EQUAL(back_end.sheddingStride(1), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(default_backlog_absorbs_a_slow_frame)
+{
+    BackEnd back_end;
+    configureBackEnd(back_end, std::vector<StereoRigCamera>());
+
+    /** A keyframe optimization four periods long **/
+    back_end.updateBacklog(base::Time::fromSeconds(0.00), 0.01);
+    back_end.updateBacklog(base::Time::fromSeconds(0.10), 0.50);
+    BOOST_CHECK(!back_end.isOverloaded());
+    BOOST_CHECK_EQUAL(back_end.sheddingStride(1), 1u);
+
+    /** The delta poses keep their rate (no coalescing) **/
+    base::samples::RigidBodyState delta_pose;
+    delta_pose.initUnknown();
+    BOOST_CHECK(back_end.addDeltaPose(delta_pose));
+    BOOST_CHECK_EQUAL(back_end.statistics().coalesced_delta_poses, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(shedding_policies)
+{
+    OverloadConfiguration overload_config;
+    overload_config.shedding_policy = SHED_DROP_FRAMES;
+    overload_config.max_backlog = 0.00;
+
+    BackEnd drop_back_end;
+    configureBackEnd(drop_back_end, std::vector<StereoRigCamera>(), overload_config);
+    drop_back_end.updateBacklog(base::Time::fromSeconds(0.00), 0.01);
+    drop_back_end.updateBacklog(base::Time::fromSeconds(0.10), 0.50);
+    BOOST_CHECK_EQUAL(drop_back_end.sheddingStride(1), 0u);
+    BOOST_CHECK_EQUAL(drop_back_end.sheddingStride(50), 1u);
+
+    overload_config.shedding_policy = SHED_SUBSAMPLE_FRAMES;
+    overload_config.subsample_factor = 2;
+    BackEnd subsample_back_end;
+    configureBackEnd(subsample_back_end, std::vector<StereoRigCamera>(), overload_config);
+    subsample_back_end.updateBacklog(base::Time::fromSeconds(0.00), 0.01);
+    subsample_back_end.updateBacklog(base::Time::fromSeconds(0.10), 0.50);
+    BOOST_CHECK_EQUAL(subsample_back_end.sheddingStride(1), 1u);
+    BOOST_CHECK_EQUAL(subsample_back_end.sheddingStride(2), 0u);
+    BOOST_CHECK_EQUAL(subsample_back_end.sheddingStride(3), 1u);
+    BOOST_CHECK_EQUAL(subsample_back_end.sheddingStride(4), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(shed_frames_keep_the_poses_linked)
+{
+    std::mt19937 generator(3);
+    const Scene scene = syntheticScene(generator);
+
+    OverloadConfiguration overload_config;
+    overload_config.shedding_policy = SHED_DROP_FRAMES;
+    overload_config.max_backlog = 0.00;
+
+    BackEnd back_end;
+    configureBackEnd(back_end, std::vector<StereoRigCamera>(), overload_config);
+
+    for (unsigned int k = 1; k <= NUMBER_FRAMES; ++k)
+    {
+        if (back_end.addDeltaPose(deltaPose(scene, k, generator)))
+        {
+            back_end.integrateDeltaPose(Eigen::Affine3d::Identity());
+        }
+
+        /** Behind after the third frame: only the keyframes 50 and 100 are processed **/
+        if (k == 4)
+        {
+            back_end.updateBacklog(back_end.statistics().time, 100.00);
+        }
+
+        const visual_stereo::ExteroFeatures frame (stereoFeatures(scene, scene.trajectory[k], k, generator));
+        BOOST_REQUIRE_NO_THROW(processFrame(back_end, &frame, 1, k));
+    }
+    BOOST_CHECK_EQUAL(back_end.statistics().dropped_frames, 95u);
+    BOOST_CHECK(back_end.poseSymbol() == gtsam::Symbol('x', 5));
+
+    /** Odometry factors: first pose and the poses after shed frames **/
+    std::vector< std::pair<gtsam::Key, gtsam::Key> > odometry_factors;
+    const gtsam::NonlinearFactorGraph &graph(back_end.graph());
+    for (size_t i = 0; i < graph.size(); ++i)
+    {
+        if (boost::dynamic_pointer_cast< gtsam::BetweenFactor<gtsam::Pose3> >(graph[i]))
+        {
+            odometry_factors.push_back(std::make_pair(graph[i]->keys()[0], graph[i]->keys()[1]));
+        }
+    }
+    BOOST_REQUIRE_EQUAL(odometry_factors.size(), 3u);
+    BOOST_CHECK(odometry_factors[0] == std::make_pair(gtsam::Key(gtsam::Symbol('x', 0)), gtsam::Key(gtsam::Symbol('x', 1))));
+    BOOST_CHECK(odometry_factors[1] == std::make_pair(gtsam::Key(gtsam::Symbol('x', 3)), gtsam::Key(gtsam::Symbol('x', 4))));
+    BOOST_CHECK(odometry_factors[2] == std::make_pair(gtsam::Key(gtsam::Symbol('x', 4)), gtsam::Key(gtsam::Symbol('x', 5))));
+
+    /** The poses of the keyframes stay close to the ground truth **/
+    BOOST_CHECK_LT((estimatedPose(back_end, 4).translation() - scene.trajectory[50].translation()).norm(), SHED_KEYFRAME_POSITION_MAX);
+    BOOST_CHECK_LT((estimatedPose(back_end, 5).translation() - scene.trajectory[100].translation()).norm(), SHED_KEYFRAME_POSITION_MAX);
+}
+
+BOOST_AUTO_TEST_CASE(landmarks_initialization_rejects_degenerate_points)
+{
+    BackEnd back_end;
+    configureBackEnd(back_end, std::vector<StereoRigCamera>());
+
+    visual_stereo::ExteroFeatures frame;
+    frame.time = base::Time::fromSeconds(FRAME_PERIOD);
+    frame.img_idx = 1;
+
+    /** Valid landmark 5 meters ahead **/
+    visual_stereo::Feature feature;
+    feature.index = landmarkIndex(1);
+    feature.stereo_point << CX + 10.00, CX + 10.00 - FX * BASELINE / 5.00, CY;
+    feature.point_3d << 10.00 * 5.00 / FX, 0.00, 5.00;
+    feature.cov_3d = 0.01 * base::Matrix3d::Identity();
+    frame.features.push_back(feature);
+
+    /** Zero disparity (point at infinity) **/
+    feature.index = landmarkIndex(2);
+    feature.stereo_point << CX, CX, CY;
+    frame.features.push_back(feature);
+
+    /** NaN stereo point **/
+    feature.index = landmarkIndex(3);
+    feature.stereo_point << std::nan(""), CX, CY;
+    frame.features.push_back(feature);
+
+    /** Front-end point far from the triangulation (Mahalanobis gate) **/
+    feature.index = landmarkIndex(4);
+    feature.stereo_point << CX, CX - FX * BASELINE / 5.00, CY;
+    feature.point_3d << 0.00, 0.00, 8.00;
+    feature.cov_3d = 0.01 * base::Matrix3d::Identity();
+    frame.features.push_back(feature);
+
+    const size_t factors = back_end.graph().size();
+    FrameStatistics frame_stats = processFrame(back_end, &frame, 1, frame.img_idx);
+
+    BOOST_CHECK_EQUAL(back_end.statistics().rejected_landmarks, 3u);
+    BOOST_CHECK(back_end.values().exists(back_end.landmarkSymbol(landmarkIndex(1))));
+    BOOST_CHECK(!back_end.values().exists(back_end.landmarkSymbol(landmarkIndex(2))));
+    BOOST_CHECK(!back_end.values().exists(back_end.landmarkSymbol(landmarkIndex(3))));
+    BOOST_CHECK(!back_end.values().exists(back_end.landmarkSymbol(landmarkIndex(4))));
+
+    /** Between factor of the first pose and the stereo factor of the valid landmark **/
+    BOOST_CHECK_EQUAL(back_end.graph().size(), factors + 2);
+    BOOST_CHECK_EQUAL(frame_stats.new_factors, 2u);
+}
+
+BOOST_AUTO_TEST_CASE(parallel_triangulation_matches_the_serial_one)
+{
+    std::mt19937 generator(5);
+    const Scene scene = syntheticScene(generator);
+
+    /** Frame of new landmarks with degenerate points spread over the chunks **/
+    const base::samples::RigidBodyState delta_pose (deltaPose(scene, 1, generator));
+    visual_stereo::ExteroFeatures frame (stereoFeatures(scene, scene.trajectory[1], 1, generator));
+    BOOST_REQUIRE_GT(frame.features.size(), 100u);
+    for (size_t i = 0; i < frame.features.size(); i += 7)
+    {
+        frame.features[i].stereo_point[1] = (i % 2)? std::nan("") : frame.features[i].stereo_point[0];
+    }
+
+    /** Ten landmarks per task: the parallel path runs whenever there is more than one worker **/
+    LandmarkConfiguration parallel_config;
+    parallel_config.parallel_min_features = 10;
+    LandmarkConfiguration serial_config;
+    serial_config.parallel_min_features = std::numeric_limits<unsigned int>::max();
+
+    BackEnd parallel_back_end, serial_back_end;
+    configureBackEnd(parallel_back_end, std::vector<StereoRigCamera>(), OverloadConfiguration(), parallel_config);
+    configureBackEnd(serial_back_end, std::vector<StereoRigCamera>(), OverloadConfiguration(), serial_config);
+    if (std::thread::hardware_concurrency() < 2)
+    {
+        BOOST_TEST_MESSAGE("Single hardware thread: the parallel triangulation runs serially");
+    }
+
+    BackEnd *back_ends[2] = {&parallel_back_end, &serial_back_end};
+    for (size_t i = 0; i < 2; ++i)
+    {
+        BOOST_REQUIRE(back_ends[i]->addDeltaPose(delta_pose));
+        back_ends[i]->integrateDeltaPose(Eigen::Affine3d::Identity());
+        processFrame(*back_ends[i], &frame, 1, frame.img_idx);
+    }
+
+    /** Same accepted set and same initial values **/
+    BOOST_CHECK_GT(parallel_back_end.statistics().rejected_landmarks, 0u);
+    BOOST_CHECK_EQUAL(parallel_back_end.statistics().rejected_landmarks, serial_back_end.statistics().rejected_landmarks);
+    BOOST_CHECK_EQUAL(parallel_back_end.graph().size(), serial_back_end.graph().size());
+    BOOST_REQUIRE_EQUAL(parallel_back_end.values().size(), serial_back_end.values().size());
+    for (size_t i = 0; i < frame.features.size(); ++i)
+    {
+        const gtsam::Symbol symbol = serial_back_end.landmarkSymbol(frame.features[i].index);
+        BOOST_REQUIRE_EQUAL(parallel_back_end.values().exists(symbol), serial_back_end.values().exists(symbol));
+        if (serial_back_end.values().exists(symbol))
+        {
+            const gtsam::Point3 parallel_point = parallel_back_end.values().at<gtsam::Point3>(symbol);
+            const gtsam::Point3 serial_point = serial_back_end.values().at<gtsam::Point3>(symbol);
+            BOOST_CHECK_SMALL((gtsam::Vector3(parallel_point) - gtsam::Vector3(serial_point)).norm(), 1e-9);
+        }
+    }
+}
+
+/***********************************************/
+/** Synthetic stereo trajectories             **/
+/***********************************************/
+
+BOOST_AUTO_TEST_CASE(stereo_trajectory)
+{
+    std::mt19937 generator(42);
+    const Scene scene = syntheticScene(generator);
+
+    BackEnd back_end;
+    configureBackEnd(back_end, std::vector<StereoRigCamera>());
+
+    std::vector<Eigen::Affine3d, Eigen::aligned_allocator<Eigen::Affine3d> > rig(1, Eigen::Affine3d::Identity());
+    const std::vector<FrameStatistics> frames_stats = runTrajectory(back_end, scene, rig, generator);
+
+    BOOST_CHECK_EQUAL(back_end.statistics().dropped_frames, 0u);
+    BOOST_CHECK_EQUAL(back_end.statistics().factors, back_end.graph().size());
+    checkTrajectoryError(back_end, scene);
+    checkFrameBudgets(frames_stats);
+}
+
+BOOST_AUTO_TEST_CASE(stereo_rig_trajectory)
+{
+    std::mt19937 generator(7);
+    const Scene scene = syntheticScene(generator);
+
+    const StereoRigCamera rig_camera = rigCamera();
+
+    BackEnd back_end;
+    configureBackEnd(back_end, std::vector<StereoRigCamera>(1, rig_camera));
+    BOOST_REQUIRE_EQUAL(back_end.numberCameras(), 2u);
+
+    std::vector<Eigen::Affine3d, Eigen::aligned_allocator<Eigen::Affine3d> > rig;
+    rig.push_back(Eigen::Affine3d::Identity());
+    rig.push_back(rig_camera.reference_camera.toTransform());
+    const std::vector<FrameStatistics> frames_stats = runTrajectory(back_end, scene, rig, generator);
+
+    checkLandmarkValues(back_end, landmarkFactors(back_end));
+    checkTrajectoryError(back_end, scene);
+    checkFrameBudgets(frames_stats);
+}
+
+BOOST_AUTO_TEST_CASE(stereo_rig_landmarks_are_deduplicated)
+{
+    std::mt19937 generator(11);
+    const Scene scene = syntheticScene(generator);
+    const StereoRigCamera rig_camera = rigCamera();
+
+    BackEnd back_end;
+    configureBackEnd(back_end, std::vector<StereoRigCamera>(1, rig_camera));
+
+    /** First frame at the initial pose: every landmark is new **/
+    std::vector<visual_stereo::ExteroFeatures> frames;
+    frames.push_back(stereoFeatures(scene, scene.trajectory[0], 1, generator));
+    frames.push_back(stereoFeatures(scene, scene.trajectory[0] * rig_camera.reference_camera.toTransform(), 1, generator));
+
+    /** Landmarks seen by both cameras **/
+    std::map<gtsam::Key, unsigned int> observations;
+    for (size_t c = 0; c < frames.size(); ++c)
+    {
+        for (size_t i = 0; i < frames[c].features.size(); ++i)
+        {
+            observations[back_end.landmarkSymbol(frames[c].features[i].index)]++;
+        }
+    }
+
+    /** A landmark inserted twice would throw in gtsam::Values::insert **/
+    BOOST_REQUIRE_NO_THROW(processFrame(back_end, &frames[0], frames.size(), 1));
+
+    /** One value per landmark and one factor per camera which accepted it **/
+    const std::map<gtsam::Key, unsigned int> landmark_factors = landmarkFactors(back_end);
+    checkLandmarkValues(back_end, landmark_factors);
+
+    size_t shared_landmarks = 0;
+    for (std::map<gtsam::Key, unsigned int>::const_iterator it = landmark_factors.begin(); it != landmark_factors.end(); ++it)
+    {
+        BOOST_CHECK_LE(it->second, observations[it->first]);
+        if (it->second == 2)
+        {
+            shared_landmarks++;
+        }
+    }
+    BOOST_TEST_MESSAGE("Landmarks " << landmark_factors.size() << " with a factor of both cameras " << shared_landmarks);
+    BOOST_CHECK_GT(shared_landmarks, 0u);
+}
@@ -13,8 +13,11 @@
 
 #include <base/Time.hpp>
 #include <base/Eigen.hpp>
+#include <base/Pose.hpp>
 #include <base/samples/RigidBodyState.hpp>
 
+#include <frame_helper/Calibration.h>
+
 namespace visual_stereo {
 
     /** Visual Stereo feature **/
@@ -37,5 +40,91 @@ namespace visual_stereo {
     typedef boost::uuids::uuid image_uuid;
 }
 
+namespace vsd_slam {
+
+    /** Additional stereo camera of the rig **/
+    struct StereoRigCamera
+    {
+        frame_helper::StereoCalibration calib; // Intrinsic and extrinsic stereo calibration parameters
+        base::Pose reference_camera; // Camera (left) frame in the reference camera frame (calib_parameters camera)
+    };
+
+    /** Features of the stereo cameras of the rig taken at the same time. The
+     * cameras are synchronized and the samples of their front-ends merged
+     * upstream: they share the time and img_idx of the pose they constrain **/
+    struct RigFeatures
+    {
+        base::Time time;
+        unsigned int img_idx;
+        std::vector<visual_stereo::ExteroFeatures> cameras; // cameras[0] is the reference camera and cameras[i] is rig_cameras[i-1]
+    };
+
+    /** Shedding policy for the feature frames which are not keyframes **/
+    enum SheddingPolicy
+    {
+        SHED_NONE, // Process every frame even when the back-end is behind
+        SHED_DROP_FRAMES, // Drop every non-keyframe while the back-end is behind
+        SHED_SUBSAMPLE_FRAMES, // Process one out of subsample_factor non-keyframes while the back-end is behind
+        SHED_SUBSAMPLE_FEATURES // Process one out of subsample_factor features of each non-keyframe while the back-end is behind
+    };
+
+    /** Overload handling configuration **/
+    struct OverloadConfiguration
+    {
+        SheddingPolicy shedding_policy; // What to do with the non-keyframes while the back-end is behind
+        unsigned int subsample_factor; // Subsampling factor for the SHED_SUBSAMPLE_* policies
+        bool coalesce_delta_poses; // Coalesce the delta poses into a single increment while the back-end is behind.
+                                   // The odometry output is then only written with the processed features samples
+        double max_backlog; // Processing backlog in seconds above which the back-end is behind. The default is a few
+                            // frame periods: a single slow frame (e.g.: a keyframe optimization) does not shed samples
+
+        OverloadConfiguration()
+            : shedding_policy(SHED_NONE), subsample_factor(2),
+            coalesce_delta_poses(true), max_backlog(0.5)
+        {
+        }
+    };
+
+    /** Landmark initialization configuration **/
+    struct LandmarkConfiguration
+    {
+        double min_disparity; // Minimum disparity in pixels of a new landmark
+        double mahalanobis_gate; // Squared Mahalanobis distance between the triangulated and the front-end point
+        unsigned int parallel_min_features; // New landmarks per thread to triangulate a frame in parallel. The default
+                                            // keeps the work of a thread about ten times the cost of waking it
+
+        LandmarkConfiguration()
+            : min_disparity(0.5), mahalanobis_gate(11.34), parallel_min_features(250)
+        {
+        }
+    };
+
+    /** Back-end statistics **/
+    struct BackEndStatistics
+    {
+        base::Time time; // Time of the last processed features sample
+        bool overloaded; // Whether the back-end is behind
+        double backlog; // Accumulated processing backlog in seconds
+        double processing_time; // Processing time of the last features sample in seconds
+        unsigned int coalesced_delta_poses; // Delta pose samples merged into a single increment
+        unsigned int dropped_frames; // Feature frames shed by the overload policy
+        unsigned int dropped_features; // Features shed by the overload policy (including the ones of dropped frames)
+        unsigned int rejected_landmarks; // New landmarks rejected by the triangulation cross-check
+        unsigned int frame_allocations; // Heap allocations of the last processed features sample in the back-end (all its
+                                        // threads, without the Task logging and port writes). Measured only when built
+                                        // with VSD_SLAM_COUNT_ALLOCATIONS, zero otherwise
+        unsigned int factors; // Number of factors in the factor graph
+        unsigned int values; // Number of estimated values (poses and landmarks)
+
+        BackEndStatistics()
+            : overloaded(false), backlog(0.0), processing_time(0.0),
+            coalesced_delta_poses(0), dropped_frames(0), dropped_features(0),
+            rejected_landmarks(0), frame_allocations(0),
+            factors(0), values(0)
+        {
+        }
+    };
+}
+
 #endif
 